@@ -0,0 +1,47 @@
+/*
+ * bitboard.c
+ *
+ * Author: Joel Foster
+ *
+ * Operations on rows of bits - see bitboard.h
+ */
+
+#include <avr/pgmspace.h>
+#include "bitboard.h"
+
+// Looking up the mask for a bit is quicker than shifting a 1 into
+// place - the AVR can only shift by one bit at a time.
+const uint8_t bitboard_masks[BITBOARD_WORD_BITS] PROGMEM = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+};
+
+// Number of bits set in each 4 bit value
+static const uint8_t nibble_popcount[16] PROGMEM = {
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+uint8_t bitboard_popcount(const uint8_t* row, uint8_t words) {
+	uint8_t count = 0;
+	for(uint8_t w = 0; w < words; w++) {
+		uint8_t word = row[w];
+		count += pgm_read_byte(&nibble_popcount[word & 0x0F]);
+		count += pgm_read_byte(&nibble_popcount[word >> 4]);
+	}
+	return count;
+}
+
+void bitboard_or_horizontal_neighbours(uint8_t* result, const uint8_t* row,
+		uint8_t words) {
+	// Bit x moves to x+1 (and x-1). Bits carry across from the top of one
+	// word into the bottom of the next (and back the other way).
+	uint8_t carry = 0;
+	for(uint8_t w = 0; w < words; w++) {
+		uint8_t word = row[w];
+		uint8_t next_word = 0;
+		if(w + 1 < words) {
+			next_word = row[w + 1];
+		}
+		result[w] |= (word << 1) | carry | (word >> 1) | (next_word << 7);
+		carry = word >> 7;
+	}
+}
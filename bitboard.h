@@ -0,0 +1,56 @@
+/*
+ * bitboard.h
+ *
+ * Author: Joel Foster
+ *
+ * Rows of bits - one bit for each cell in a row of the game field.
+ * A row is stored as an array of 8 bit words (bytes): bit x of the
+ * row is bit (x % 8) of word (x / 8). Rows can therefore be any width,
+ * and because the AVR works on 8 bits at a time, testing or changing
+ * a bit never needs a shift of a 32 bit value by a variable amount.
+ * Bits beyond the width of a row are unused.
+ */
+
+#ifndef BITBOARD_H_
+#define BITBOARD_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#define BITBOARD_WORD_BITS 8
+
+// Number of words needed to hold a row of the given width
+#define BITBOARD_ROW_WORDS(width) \
+		(((width) + BITBOARD_WORD_BITS - 1) / BITBOARD_WORD_BITS)
+
+// bitboard_masks[n] has only bit n set (see bitboard.c)
+extern const uint8_t bitboard_masks[BITBOARD_WORD_BITS] PROGMEM;
+
+// Returns non-zero if bit x of the row is set, 0 otherwise
+static inline uint8_t bitboard_test(const uint8_t* row, uint8_t x) {
+	return row[x / BITBOARD_WORD_BITS]
+			& pgm_read_byte(&bitboard_masks[x % BITBOARD_WORD_BITS]);
+}
+
+// Set bit x of the row
+static inline void bitboard_set(uint8_t* row, uint8_t x) {
+	row[x / BITBOARD_WORD_BITS]
+			|= pgm_read_byte(&bitboard_masks[x % BITBOARD_WORD_BITS]);
+}
+
+// Clear bit x of the row
+static inline void bitboard_clear(uint8_t* row, uint8_t x) {
+	row[x / BITBOARD_WORD_BITS]
+			&= ~pgm_read_byte(&bitboard_masks[x % BITBOARD_WORD_BITS]);
+}
+
+// Returns the number of bits set in the first "words" words of the row
+uint8_t bitboard_popcount(const uint8_t* row, uint8_t words);
+
+// ORs into result the bits of row shifted one column left and one
+// column right, i.e. sets the bits of the horizontal neighbours of every
+// set bit. Both rows are "words" words long.
+void bitboard_or_horizontal_neighbours(uint8_t* result, const uint8_t* row,
+		uint8_t words);
+
+#endif /* BITBOARD_H_ */
@@ -1,95 +1,100 @@
-/*
- * buttons.c
- *
- * Author: Peter Sutton
- */ 
-
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include "buttons.h"
-
-// Global variable to keep track of the last button state so that we 
-// can detect changes when an interrupt fires. The lower 4 bits (0 to 3)
-// will correspond to the last state of port B pins 0 to 3.
-static volatile uint8_t last_button_state;
-
-// Our button queue. button_queue[0] is always the head of the queue. If we
-// take something off the queue we just move everything else along. We don't
-// use a circular buffer since it is usually expected that the queue is very
-// short. In most uses it will never have more than 1 element at a time.
-// This button queue can be changed by the interrupt handler below so we should
-// turn off interrupts if we're changing the queue outside the handler.
-#define BUTTON_QUEUE_SIZE 4
-static volatile uint8_t button_queue[BUTTON_QUEUE_SIZE];
-static volatile int8_t queue_length;
-
-// Setup interrupt if any of pins B0 to B3 change. We do this
-// using a pin change interrupt. These pins correspond to pin
-// change interrupts PCINT8 to PCINT11 which are covered by
-// Pin change interrupt 1.
-void init_button_interrupts(void) {
-	// Enable the interrupt (see datasheet page 77)
-	PCICR |= (1<<PCIE1);
-	
-	// Make sure the interrupt flag is cleared (by writing a 
-	// 1 to it) (see datasheet page 78)
-	PCIFR |= (1<<PCIF1);
-	
-	// Choose which pins we're interested in by setting
-	// the relevant bits in the mask register (see datasheet page 78)
-	PCMSK1 |= (1<<PCINT8)|(1<<PCINT9)|(1<<PCINT10)|(1<<PCINT11);	
-	
-	// Empty the button push queue
-	queue_length = 0;
-}
-
-int8_t button_pushed(void) {
-	int8_t return_value = NO_BUTTON_PUSHED;	// Assume no button pushed
-	if(queue_length > 0) {
-		// Remove the first element off the queue and move all the other
-		// entries closer to the front of the queue. We turn off interrupts (if on)
-		// before we make any changes to the queue. If interrupts were on
-		// we turn them back on when done.
-		return_value = button_queue[0];
-		
-		// Save whether interrupts were enabled and turn them off
-		int8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
-		cli();
-		
-		for(uint8_t i = 1; i < queue_length; i++) {
-			button_queue[i-1] = button_queue[i];
-		}
-		queue_length--;
-		
-		if(interrupts_were_enabled) {
-			// Turn them back on again
-			sei();
-		}
-	}
-	return return_value;
-}
-
-// Interrupt handler for a change on buttons
-ISR(PCINT1_vect) {
-	// Get the current state of the buttons. We'll compare this with
-	// the last state to see what has changed.
-	uint8_t button_state = PINB & 0x0F;
-	
-	// Iterate over all the buttons and see which ones have changed.
-	// Any button pushes are added to the queue of button pushes (if
-	// there is space). We ignore button releases so we're just looking
-	// for a transition from 0 in the last_button_state bit to a 1 in the 
-	// button_state.
-	for(uint8_t pin=0; pin<=3; pin++) {
-		if(queue_length < BUTTON_QUEUE_SIZE && 
-				(button_state & (1<<pin)) && 
-				!(last_button_state & (1<<pin))) {
-			// Add the button push to the queue (and update the
-			// length of the queue
-			button_queue[queue_length++] = pin;
-		}
-	}
-	
-	// Remember this button state
-	last_button_state = button_state;
-}
\ No newline at end of file
+/*
+ * buttons.c
+ *
+ * Author: Peter Sutton
+ */ 
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "buttons.h"
+
+#if BUTTON_QUEUE_SIZE & (BUTTON_QUEUE_SIZE - 1)
+#error "BUTTON_QUEUE_SIZE must be a power of 2"
+#endif
+
+// The debounced state of the buttons. The lower 4 bits (0 to 3) correspond
+// to port B pins 0 to 3 (1 if the button is pushed).
+static volatile uint8_t button_state;
+
+// Number of samples in a row each pin has differed from button_state
+static uint8_t changed_samples[4];
+
+// Our queue of button events - a ring of BUTTON_QUEUE_SIZE events starting
+// at position first. Events are added by the interrupt handler (through
+// buttons_sample()) so we turn off interrupts while taking one off the
+// queue outside the handler.
+static volatile ButtonEvent button_queue[BUTTON_QUEUE_SIZE];
+static volatile uint8_t first;
+static volatile uint8_t queue_length;
+
+void init_buttons(void) {
+	// Pins B0 to B3 are inputs
+	DDRB &= 0xF0;
+	
+	// Take the buttons' current state as the starting point (so a button
+	// held down at start up isn't counted as a push)
+	button_state = PINB & 0x0F;
+	for(uint8_t pin = 0; pin <= 3; pin++) {
+		changed_samples[pin] = 0;
+	}
+	
+	// Empty the button event queue
+	first = 0;
+	queue_length = 0;
+}
+
+void buttons_sample(uint16_t time) {
+	uint8_t changed = (PINB & 0x0F) ^ button_state;
+	
+	for(uint8_t pin = 0; pin <= 3; pin++) {
+		if(!(changed & (1<<pin))) {
+			// Still at the debounced level (or it bounced back to it)
+			changed_samples[pin] = 0;
+		} else if(++changed_samples[pin] == BUTTON_DEBOUNCE_MS) {
+			// The pin has settled at its new level - add the push or
+			// release to the queue (if there is space)
+			changed_samples[pin] = 0;
+			button_state ^= (1<<pin);
+			if(queue_length < BUTTON_QUEUE_SIZE) {
+				volatile ButtonEvent* event =
+						&button_queue[(first + queue_length) & (BUTTON_QUEUE_SIZE - 1)];
+				event->button = pin;
+				event->pressed = (button_state >> pin) & 1;
+				event->time = time;
+				queue_length++;
+			}
+		}
+	}
+}
+
+uint8_t button_event(ButtonEvent* event) {
+	if(queue_length == 0) {
+		return 0;
+	}
+	// Save whether interrupts were enabled and turn them off while we
+	// take the event off the queue
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	
+	event->button = button_queue[first].button;
+	event->pressed = button_queue[first].pressed;
+	event->time = button_queue[first].time;
+	first = (first + 1) & (BUTTON_QUEUE_SIZE - 1);
+	queue_length--;
+	
+	if(interrupts_were_enabled) {
+		// Turn them back on again
+		sei();
+	}
+	return 1;
+}
+
+int8_t button_pushed(void) {
+	ButtonEvent event;
+	while(button_event(&event)) {
+		if(event.pressed) {
+			return event.button;
+		}
+	}
+	return NO_BUTTON_PUSHED;
+}
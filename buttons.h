@@ -1,34 +1,63 @@
-/*
- * buttons.h
- *
- * Author: Peter Sutton
- *
- * We assume four push buttons (B0 to B3) are connected to pins B0 to B3. We configure
- * pin change interrupts on these pins.
- */ 
-
-
-#ifndef BUTTONS_H_
-#define BUTTONS_H_
-
-#include <stdint.h>
-
-#define NO_BUTTON_PUSHED (-1)
-
-/* Set up pin change interrupts on pins B0 to B3.
- * It is assumed that global interrupts are off when this function is called
- * and are enabled sometime after this function is called.
- */
-void init_button_interrupts(void);
-
-/* Return the last button pushed (0 to 3) or -1 (NO_BUTTON_PUSHED) if 
- * there are no button pushes to return. (A small queue of button pushes
- * is kept. This function should be called frequently enough to
- * ensure the queue does not overflow. Excess button pushes are
- * discarded.)
- */
-
-int8_t button_pushed(void);
-
-
-#endif /* BUTTONS_H_ */
\ No newline at end of file
+/*
+ * buttons.h
+ *
+ * Author: Peter Sutton
+ *
+ * We assume four push buttons (B0 to B3) are connected to pins B0 to B3.
+ * The pins are sampled every millisecond from the timer 0 interrupt
+ * handler (see timer0.c) and a button is only taken to have been pushed
+ * (or released) once its pin has read the new level for BUTTON_DEBOUNCE_MS
+ * samples in a row - so contact bounce doesn't produce extra pushes.
+ * Each push and release is put in a queue of button events along with the
+ * time it happened.
+ */ 
+
+
+#ifndef BUTTONS_H_
+#define BUTTONS_H_
+
+#include <stdint.h>
+
+#define NO_BUTTON_PUSHED (-1)
+
+// Number of milliseconds a pin must stay at its new level before the
+// button counts as pushed or released
+#define BUTTON_DEBOUNCE_MS 5
+
+// Number of button events that can be waiting (must be a power of 2).
+// Excess events are discarded.
+#define BUTTON_QUEUE_SIZE 8
+
+typedef struct {
+	int8_t button;		// 0 to 3
+	uint8_t pressed;	// 1 if the button was pushed, 0 if released
+	uint16_t time;		// low 16 bits of get_current_time() (see timer0.h)
+} ButtonEvent;
+
+/* Set up pins B0 to B3 as inputs and empty the queue of button events.
+ * The buttons are sampled once timer 0 has been set up (see timer0.h)
+ * and global interrupts are enabled.
+ */
+void init_buttons(void);
+
+/* Sample the buttons - called by the timer 0 interrupt handler every
+ * millisecond with the current time.
+ */
+void buttons_sample(uint16_t time);
+
+/* Take the oldest button event off the queue. Returns 1 if there was one
+ * (and it is copied to *event), 0 if there are no events waiting.
+ * The latency of an input can be found by comparing the event's time
+ * with (uint16_t)get_current_time() when it is acted on.
+ */
+uint8_t button_event(ButtonEvent* event);
+
+/* Return the next button pushed (0 to 3) or -1 (NO_BUTTON_PUSHED) if 
+ * there are no button pushes to return. Button releases are taken
+ * off the queue and ignored. This function (or button_event()) should
+ * be called frequently enough to ensure the queue does not overflow.
+ */
+int8_t button_pushed(void);
+
+
+#endif /* BUTTONS_H_ */
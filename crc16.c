@@ -0,0 +1,27 @@
+/*
+ * crc16.c
+ *
+ * Author: Joel Foster
+ */
+
+#include "crc16.h"
+
+uint16_t crc16_update(uint16_t crc, uint8_t data) {
+	crc ^= (uint16_t)data << 8;
+	for(uint8_t i = 0; i < 8; i++) {
+		if(crc & 0x8000) {
+			crc = (crc << 1) ^ 0x1021;
+		} else {
+			crc <<= 1;
+		}
+	}
+	return crc;
+}
+
+uint16_t crc16_block(uint16_t crc, const void* data, uint16_t length) {
+	const uint8_t* bytes = data;
+	while(length--) {
+		crc = crc16_update(crc, *bytes++);
+	}
+	return crc;
+}
@@ -0,0 +1,25 @@
+/*
+ * crc16.h
+ *
+ * Author: Joel Foster
+ *
+ * 16 bit cyclic redundancy check (CRC-16/CCITT - polynomial 0x1021,
+ * starting value 0xFFFF) for checking that data is unchanged. Plain C so
+ * that the same values can be worked out on the development computer.
+ */
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+#include <stdint.h>
+
+#define CRC16_INITIAL_VALUE 0xFFFF
+
+// Returns the CRC after adding the given byte to data with CRC crc
+uint16_t crc16_update(uint16_t crc, uint8_t data);
+
+// Returns the CRC after adding length bytes (starting at data) to data
+// with CRC crc
+uint16_t crc16_block(uint16_t crc, const void* data, uint16_t length);
+
+#endif /* CRC16_H_ */
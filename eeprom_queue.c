@@ -0,0 +1,106 @@
+/*
+ * eeprom_queue.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "eeprom_queue.h"
+
+// Maximum number of bytes checked each time the interrupt handler runs - so
+// that skipping a long run of unchanged bytes doesn't hold up the other
+// interrupts (the handler runs again straight away if there is more to do)
+#define MAX_BYTES_CHECKED 16
+
+typedef struct {
+	uint16_t address;
+	const uint8_t* source;
+	uint16_t length;
+} QueuedBlock;
+
+// The queue - a ring of blocks starting at position first. The first block
+// is the one being written - its address, source and length are moved on
+// as each byte is done. The queue can be changed by the interrupt handler
+// below so interrupts are turned off when changing it outside the handler.
+static volatile QueuedBlock queue[EEPROM_QUEUE_SIZE];
+static volatile uint8_t first;
+static volatile uint8_t queue_length;
+
+uint8_t eeprom_queue_write(void* address, const void* source, uint16_t length) {
+	uint8_t result = 0;
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if(queue_length < EEPROM_QUEUE_SIZE) {
+		volatile QueuedBlock* block = &queue[(first + queue_length) % EEPROM_QUEUE_SIZE];
+		block->address = (uint16_t)address;
+		block->source = source;
+		block->length = length;
+		queue_length++;
+		// The interrupt fires whenever the EEPROM is ready for another write
+		EECR |= (1<<EERIE);
+		result = 1;
+	}
+	if(interrupts_were_enabled) {
+		sei();
+	}
+	return result;
+}
+
+uint16_t eeprom_queue_bytes_remaining(void) {
+	uint16_t remaining = 0;
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	for(uint8_t i = 0; i < queue_length; i++) {
+		remaining += queue[(first + i) % EEPROM_QUEUE_SIZE].length;
+	}
+	if(interrupts_were_enabled) {
+		sei();
+	}
+	return remaining;
+}
+
+uint8_t eeprom_queue_busy(void) {
+	return queue_length != 0;
+}
+
+void eeprom_queue_wait(void) {
+	// (A block is only removed from the queue once its last byte has been
+	// written)
+	while(queue_length) {
+		; // wait
+	}
+}
+
+// Interrupt handler for the EEPROM being ready (i.e. not writing). We look
+// for the next byte that needs to be written and start writing it - the
+// interrupt fires again when the write is complete.
+ISR(EE_READY_vect) {
+	uint8_t checked = 0;
+	while(queue_length) {
+		volatile QueuedBlock* block = &queue[first];
+		while(block->length) {
+			if(checked++ == MAX_BYTES_CHECKED) {
+				return;
+			}
+			EEAR = block->address;
+			EECR |= (1<<EERE);
+			uint8_t value = *block->source;
+			block->address++;
+			block->source++;
+			block->length--;
+			if(EEDR != value) {
+				EEDR = value;
+				// EEPE must be set within 4 clock cycles of EEMPE (interrupts
+				// are already off in here)
+				EECR |= (1<<EEMPE);
+				EECR |= (1<<EEPE);
+				return;
+			}
+		}
+		first = (first + 1) % EEPROM_QUEUE_SIZE;
+		queue_length--;
+	}
+	// Nothing left to write
+	EECR &= ~(1<<EERIE);
+}
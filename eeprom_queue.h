@@ -0,0 +1,41 @@
+/*
+ * eeprom_queue.h
+ *
+ * Author: Joel Foster
+ *
+ * Background EEPROM writes. Writing a byte of EEPROM takes about 3.3ms, so
+ * rather than waiting for each one, blocks of data are queued here and
+ * written by the EEPROM ready interrupt a byte at a time while the game
+ * carries on. Bytes that already hold the right value are skipped (reading
+ * is quick, and it saves wearing out the EEPROM).
+ *
+ * The data in a queued block is read as it is written, so it must not be
+ * changed until the queue is done with it. The avr-libc eeprom_ functions
+ * must not be used while the queue is busy (they would upset the address
+ * the interrupt handler is using) - call eeprom_queue_wait() first.
+ */
+
+#ifndef EEPROM_QUEUE_H_
+#define EEPROM_QUEUE_H_
+
+#include <stdint.h>
+
+// Maximum number of blocks waiting to be written
+#define EEPROM_QUEUE_SIZE 4
+
+// Queue length bytes from source (in RAM) to be written to the given
+// address in the EEPROM. Returns 1 if successful, 0 if the queue is full.
+uint8_t eeprom_queue_write(void* address, const void* source, uint16_t length);
+
+// Returns the number of bytes still to be written (or checked)
+uint16_t eeprom_queue_bytes_remaining(void);
+
+// Returns 1 if there is anything still to be written (the last byte of a
+// block may still be being written when eeprom_queue_bytes_remaining()
+// returns 0), 0 otherwise
+uint8_t eeprom_queue_busy(void);
+
+// Wait until everything queued has been written
+void eeprom_queue_wait(void);
+
+#endif /* EEPROM_QUEUE_H_ */
@@ -1,846 +1,1557 @@
-/*
-** game.c
-**
-** Author: Peter Sutton
-**
-*/
-
-#include "game.h"
-#include "score.h"
-#include <stdio.h>
-#include "ledmatrix.h"
-#include "terminalio.h"
-#include "line_drawing_characters.h"
-#include "pixel_colour.h"
-#include <avr/pgmspace.h>
-#include <stdlib.h>
-#include "../../PacManProjectFiles/score.h"
-#include "timer0.h"
-
-/* Stdlib needed for random() - random number generator */
-
-///////////////////////////////////////////////////////////
-// Initial game field
-// The string below has 31 elements for each of the 31 rows. The index into 
-// the string is row_number * 31 + column_number.
-// Each location is one of the following values:
-// (space) - nothing at this location
-// - - horizontal wall at this location - uses LINE_HORIZONTAL
-// | - vertical wall at this location - uses LINE_VERTICAL
-// F - wall is down and to the right - uses LINE_DOWN_AND_RIGHT
-// 7 - wall is down and to the left - uses LINE_DOWN_AND_LEFT
-// L - wall is up and to the right - uses LINE_UP_AND_RIGHT
-// J - wall is up and to the left - uses LINE_UP_AND_LEFT
-// > - wall is vertical and to the right - uses LINE_VERTICAL_AND_RIGHT
-// < - wall is vertical and to the left - uses LINE_VERTICAL_AND_LEFT
-// ^ - wall is horizontal and up - uses LINE_HORIZONTAL_AND_UP
-// v - wall is horizontal and down - uses LINE_HORIZONTAL_AND_DOWN
-// + - wall is in all directions - uses LINE_VERTICAL_AND_HORIZONTAL
-// . - pacdot initially at this location
-// P - power pellet initial location (initially implemented just as a pac-dot)
-//
-// This array is stored in program memory to preserve RAM. (1 is added to 
-// size to allow for null character at end of string.)
-// (Note that string constants with whitespace between them are concatenated.)
-
-static const char init_game_field[FIELD_HEIGHT*FIELD_WIDTH + 1] PROGMEM =
-	"F-------------v-v-------------7"
-	"|.............| |.............|"
-	"|.F---7.F---7.| |.F---7.F---7.|"
-	"|.|   |.L---J.L-J.L---J.|   |.|"
-	"|.|   |.................|   |.|"
-	"|.|   |.F---7.F-7.F---7.|   |.|"
-	"|PL---J.L---J.L-J.L---J.L---JP|"
-	"|.............................|"
-	"|.F---7.F7.F-------7.F7.F---7.|"
-	"|.L---J.||.L--7 F--J.||.L---J.|"
-	"|.......||....| |....||.......|"
-	"L-----7.|L--7 | | F--J|.F-----J"
-	"      |.|F--J L-J L--7|.|      "
-	"      |.||           ||.|      "
-	"------J.LJ F--   --7 LJ.L------"
-	"       .   |       |   .       "
-	"------7.F7 L-------J F7.F------"
-	"      |.||           ||.|      "
-	"      |.|| F-------7 ||.|      "
-	"F-----J.LJ L--7 F--J LJ.L-----7"
-	"|.............| |.............|"
-	"|.F---7.F---7.| |.F---7.F---7.|"
-	"|.L-7 |.L---J.L-J.L---J.| F-J.|"
-	"|P..| |........ ........| |..P|"
-	">-7.| |.F7.F-------7.F7.| |.F-<"
-	">-J.L-J.||.L--7 F--J.||.L-J.L-<"
-	"|.......||....| |....||.......|"
-	"|.F-----JL--7.| |.F--JL-----7.|"
-	"|.L---------J.L-J.L---------J.|"
-	"|.............................|"
-	"L-----------------------------J";
-
-// Array to store the game dots (pacdots) - each element in the array is a 32 bit integer, 
-// representing the absence/presence of pacdots in each row. The first element in 
-// the array is for row 0 (top), the last for row 30 (bottom).
-// Within the 32-bit integer, the least significant 31 bits are used to store
-// the data for each column in that row. The least significant bit (bit 0) is the value
-// for column 0 (left hand column), the second most significant bit (bit 30) is for
-// column 30 (right hand column). The most significant bit (bit 31) is unused. A value
-// of 1 in a bit represents the presence of a pacdot, 0 is the absence.
-//
-
-// We also keep a count of the number of pac-dots remaining on the game field
-static uint16_t num_pacdots;
-
-// Initial pacman location and direction
-#define INIT_PACMAN_X 15
-#define INIT_PACMAN_Y 23
-#define INIT_PACMAN_DIRN DIRN_RIGHT
-
-// Location of the ghost's home - ghosts will be every 2 cells
-// starting from the left most position (12,15) to (18,15)
-#define GHOST_HOME_Y 15
-#define GHOST_HOME_X_LEFT 12
-#define GHOST_HOME_X_RIGHT 18
-#define GHOST_HOME_ENTRY_Y 14
-#define GHOST_HOME_ENTRY_X_LEFT 14
-#define GHOST_HOME_ENTRY_X_RIGHT 16
-#define INIT_GHOST_DIRN DIRN_RIGHT
-
-// Values to represent the contents of a cell (x,y)
-// Non-negative values are used for ghost numbers (0 to 3)
-#define CELL_IS_GHOST_HOME (-1)
-#define CELL_IS_WALL (-2)
-#define CELL_CONTAINS_PACMAN (-3)
-#define CELL_CONTAINS_PACDOT (-4)
-#define CELL_EMPTY (-5)
-#define CELL_CONTAINS_POWER_PELLET (-6)
-
-// Maximum Pacman Lives
-#define MAX_LIVES (3)
-// Pacman Lives
-uint8_t lives = MAX_LIVES;
-// LED Display Value 
-static int8_t lives_led = 7;
-
-uint8_t power_active = 0;
-uint8_t ghost_kills = 0;
-
-uint8_t disabled_ghosts[NUM_GHOSTS] = {
-	-1, -1, -1, -1
-};
-
-uint8_t ghost_original_colours[NUM_GHOSTS] = {
-	BG_RED, BG_GREEN, BG_CYAN, BG_MAGENTA
-};
-
-uint8_t ghost_colours[NUM_GHOSTS] = {
-	BG_RED, BG_GREEN, BG_CYAN, BG_MAGENTA
-};
-
-#define PACMAN_COLOUR (FG_YELLOW)
-
-// Unicode characters used to represent the pacman in each direction
-static const char* pacman_characters[NUM_DIRECTION_VALUES] = {
-	"\u15E4", "\u15E2", "\u15E7", "\u15E3"
-};
-
-// Indicate whether the game is running or not - 1 indicates yes,
-// 0 indicates game over
-static uint8_t game_running;
-
-///////////////////////////////////////////////////////////
-// Private Functions
-//
-// is_wall_at() returns true (1) if there is a wall at the given 
-// game location, 0 otherwise
-static int8_t is_wall_at (uint8_t x, uint8_t y) {
-	// Get information about any wall in that position
-	char wall_character = pgm_read_byte(& init_game_field[y * FIELD_WIDTH + x]);
-	return (wall_character != ' ' && wall_character != '.'
-			&& wall_character != 'P');
-}
-
-void display_score(void) {
-	move_cursor(50,20);
-	printf_P(PSTR("Score /n %d /n High Score /n %d"), 1.0, "Score", get_score(), "High Score", get_highscore());
-}
-
-// is_pacman_at() returns true(1) if the pacman is at the given 
-// game location (x,y), 0 otherwise
-static int8_t is_pacman_at(uint8_t x, uint8_t y) {
-	return (x == pacman_x && y == pacman_y);
-}
-
-// is_pacdot_at() returns true (1) if there is a pacdot at the given
-// game location, 0 otherwise
-static int8_t is_pacdot_at (uint8_t x, uint8_t y) {
-	// Get the details for the row
-	uint32_t dots_on_row = pacdots[y];
-	// Extract the value for the column x (which is in bit x)
-	if(dots_on_row & (1UL<< x)) {
-		return 1;
-	} else {
-		return 0;
-	}
-}
-
-// is_power_pellet_at() returns true (1) if there is a power pellet at the given
-// game location, 0 otherwise
-static int8_t is_power_pellet_at (uint8_t x, uint8_t y) {
-	// Get the details for the row
-	uint32_t dots_on_row = power_pellets[y];
-	// Extract the value for the column x (which is in bit x)
-	if(dots_on_row & (1UL<< x)) {
-		return 1;
-		} else {
-		return 0;
-	}
-}
-
-// Returns true (1) if the given location is the home of the ghosts
-// (this includes the entry to the home of the ghosts)
-static int8_t is_ghost_home(uint8_t x, uint8_t y) {
-	if(y == GHOST_HOME_Y && x >= GHOST_HOME_X_LEFT && x <= GHOST_HOME_X_RIGHT) {
-		return 1;
-	} else if(y == GHOST_HOME_ENTRY_Y && x >= GHOST_HOME_ENTRY_X_LEFT
-			&& x <= GHOST_HOME_ENTRY_X_RIGHT) {
-		return 1;
-	} else {
-		return 0;
-	}
-}
-
-static void display_no_dots(void) {
-	move_cursor(50,10);
-	printf_P(PSTR("Number of Pacdots : %d"), num_pacdots);
-}
-
-// The pac-man has just arrived in a location occupied by a pac-dot. Update
-// our array which keeps track of remaining pacdots. Update and output the
-// count of remaining pac-dots.
-// See initialise_pacdots() below for information on how the pacdots array
-// is initialised.
-static void eat_pacdot(void) {
-	// Update Location to Contain No Dot
-	pacdots[pacman_y] |= (0UL<<pacman_x);
-	// Update Number of Pacdots
-	num_pacdots--;
-	// Update Current Score
-	add_to_score(10);
-	display_score();
-	display_no_dots();
-}
-
-// The pac-man has just arrived in a location occupied by a power pellet. Update
-// our array which keeps track of remaining power pellets.
-// See initialise_power_pellets() below for information on how the power pellet array
-// is initialised.
-static void eat_power_pellet(void) {
-	if (power_active) {
-		ghost_kills = 0;
-		disabled_ghosts[0] = -1;
-		disabled_ghosts[1] = -1;
-		disabled_ghosts[2] = -1;
-		disabled_ghosts[3] = -1;
-	}
-	power_active = 1;
-	// Update Location to Contain No Dot
-	power_pellets[pacman_y] |= (0UL<<pacman_x);
-	// Update Current Score
-	add_to_score(50);
-	display_score();
-	for (int8_t i = 0; i < NUM_GHOSTS; i++) {
-		ghost_colours[i] = FG_BLUE;
-	}
-	powered_period = get_current_time();
-}
-
-static void display_lives(void) {
-	switch(lives) {
-		case 0:
-			lives_led = 0;
-			break;
-		case 1:
-			lives_led = 1;
-			break;
-		case 2:
-			lives_led = 3;
-			break;
-		case 3:
-			lives_led = 7;
-			break;
-	}
-	PORTC = lives_led;
-}
-
-// what_is_at(x,y) returns
-//		CELL_EMPTY, CELL_CONTAINS_PACDOT, CELL_CONTAINS_PACMAN, CELL_IS_WALL,
-//		CELL_IS_GHOST_HOME or the ghost number if the cell contains a ghost
-static int8_t what_is_at(uint8_t x, uint8_t y) {
-	if(is_pacman_at(x,y)) {
-		return CELL_CONTAINS_PACMAN;
-	} else { // Check for ghosts next - these take priority over dots
-		// BUT note that there may be a pacdot at the same location
-		for(int8_t i = 0; i < NUM_GHOSTS; i++) {
-			if(x == ghost_x[i] && y == ghost_y[i]) {
-				return i;	// ghost number
-			}
-		}
-	}
-	if (is_pacdot_at(x,y)) {
-		return CELL_CONTAINS_PACDOT;
-	} else if (is_wall_at(x,y)) {
-		return CELL_IS_WALL;
-	} else if(is_ghost_home(x,y)) {
-		return CELL_IS_GHOST_HOME;
-	}
-	// If we get here, we haven't found anything else - cell is empty
-	return CELL_EMPTY;
-}
-
-// what_is_in_dirn(x,y,direction) returns what is in the cell one from
-// the cell at (x,y) in the given direction - provided that is not off
-// the game field. (If it is, we just indicate that a wall is there.)
-// We check for a wall first because this also checks that we're not at the edge
-int8_t what_is_in_dirn(uint8_t x, uint8_t y, uint8_t direction) {
-	// delta_x and delta_y keep track of the change to the current x,y
-	// - we set these based on the direction we're checking in. One of these
-	// will end up as -1 or +1, the other will stay at 0.
-	int8_t delta_x = 0;
-	int8_t delta_y = 0;
-	switch(direction) {
-		case DIRN_LEFT:
-		if(x == 0) {
-			// We can't move left since we're at the edge
-			return CELL_IS_WALL;
-		}
-		delta_x = -1;
-		break;
-		case DIRN_RIGHT:
-		if(x == FIELD_WIDTH-1) {
-			// We can't move right since we're at the edge
-			return CELL_IS_WALL;
-		}
-		delta_x = 1;
-		break;
-		case DIRN_UP:
-		if(y == 0) {
-			// We can't move up since we're at the edge
-			return CELL_IS_WALL;
-		}
-		delta_y = -1;
-		break;
-		case DIRN_DOWN:
-		if(y == FIELD_HEIGHT-1) {
-			// We can't move down since we're at the edge
-			return CELL_IS_WALL;
-		}
-		delta_y = 1;
-		break;
-		default:	// Shouldn't happen - we just return CELL_IS_WALL if
-		// the direction given is invalid
-		return CELL_IS_WALL;
-	}
-	return what_is_at(x + delta_x, y + delta_y);
-}
-
-// determine_dirns_ghost_can_move_in()
-// Returns a number that indicates whether a ghost at the given x,y location
-// can move in each direction. The lower 4 bits of the return value will each
-// be 0 or 1 - 0 means can't move in the direction, 1 means can move. The bit
-// positions are
-// - 0 (DIRN_LEFT) (least significant) - left
-// - 1 (DIRN_RIGHT) - right
-// - 2 (DIRN_UP) - up
-// - 3 (DIRN_DOWN) - down
-// Movement in the given direction can only happen if the cell is one of
-// - the pacman
-// - a pacdot
-// - empty
-// It can not move there if the cell is a ghost or a wall.
-// If we're in the ghost home we can move to another cell in the ghost home.
-// If we're outside the ghost home we can't move into it.
-static int8_t determine_dirns_ghost_can_move_in(uint8_t x, uint8_t y) {
-	int8_t return_value = 0;
-	int8_t posn_is_in_ghost_home = is_ghost_home(x,y);
-	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
-		int8_t adjacent_cell_contents = what_is_in_dirn(x,y,dirn);
-		
-		if(adjacent_cell_contents < CELL_IS_WALL) {
-			// cell is empty or pacdot or pacman
-			return_value |= (1 << dirn);
-		} else if(posn_is_in_ghost_home && adjacent_cell_contents == CELL_IS_GHOST_HOME) {
-			// we're in the ghost home and can move to an empty cell in the ghost home
-			return_value |= (1 << dirn);
-		} 
-	}
-	return return_value;
-}
-
-// direction_to_pacman() is called for a ghost position and we return a direction
-// to move in that will take us closer to the pacman (from DIRN_LEFT to DIRN_DOWN)
-// or -1 if we can't move at all. (Note we can only move into cells that are empty
-// OR contain a pacdot OR contain the pacman. We can't move into walls or cells 
-// that contain ghosts.)
-static int8_t direction_to_pacman(uint8_t x, uint8_t y) {
-	int8_t delta_x = pacman_x - x;
-	int8_t delta_y = pacman_y - y;
-	// Work out which direction options are possible
-	int8_t dirn_options = determine_dirns_ghost_can_move_in(x, y);
-	if(dirn_options == 0) {
-		// Can't move
-		return -1;
-	}
-	
-	if(abs(delta_x) < abs(delta_y)) {
-		// Pacman is further away in y direction - try this direction (up/down) first
-		if(delta_y < 0) {
-			if(dirn_options & (1 << DIRN_UP)) {
-				return DIRN_UP;
-			}
-			// Can't move up - move on to checking left/right
-		} else if(delta_y > 0) {
-			if(dirn_options & (1 << DIRN_DOWN)) {
-				return DIRN_DOWN;
-			}
-			// Can't move down - move on to checking left/right
-		} // else delta_y is 0 - so try left/right
-	}
-	// Try the x direction 
-	if(delta_x < 0) {
-		if(dirn_options & (1 << DIRN_LEFT)) {
-			return DIRN_LEFT;
-		}
-		// Pacman is left but we can't move left - try up or down
-		if(delta_y < 0) {
-			if(dirn_options & (1 << DIRN_UP)) {
-				return DIRN_UP;
-			}
-		} else if(dirn_options & (1 << DIRN_DOWN)) {
-			return DIRN_DOWN;
-		}
-	} else {
-		if(dirn_options & (1 << DIRN_RIGHT)) {
-			return DIRN_RIGHT;
-		}
-		// Pacman is right (or directly above/below) but we can't move right - try up or down
-		if(delta_y < 0) {
-			if(dirn_options & (1 << DIRN_UP)) {
-				return DIRN_UP;
-			} 
-		} else if(dirn_options & (1 << DIRN_DOWN)) {
-			return DIRN_DOWN;
-		}
-	}
-	// Just move whichever way we can - try until we find one that works
-	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
-		if(dirn_options & (1 << dirn)) {
-			return dirn;
-		}
-	}
-	// We can't move in any direction
-	return -1;
-}
-
-// determine_ghost_direction_to_move()
-// 
-// Determine the direction the given ghost (0 to 3) should move in.
-// (Each ghost uses a different approach to moving.)
-// Return -1 if the ghost can't move (e.g. surrounded by walls and other
-// ghosts).
-static int8_t determine_ghost_direction_to_move(uint8_t ghostnum) {
-	uint8_t x = ghost_x[ghostnum];
-	uint8_t y = ghost_y[ghostnum];
-	uint8_t curdirn = ghost_direction[ghostnum];
-
-	int8_t dirn_options = determine_dirns_ghost_can_move_in(x,y);
-	if(dirn_options == 0) {
-		// ghost has no options - indicate that the ghost can't move
-		return -1;
-	}
-	
-	if(is_ghost_home(x,y)) {
-		// Attempt to move ghost out of home - try UP
-		if(dirn_options & (1 << DIRN_UP)) {
-			return DIRN_UP;
-		}
-		// If this doesn't work, we'll try the usual algorithm
-	}
-	switch(ghostnum) {
-		case 0:
-			// Ghost 0 will always try to move towards the pacman
-			return direction_to_pacman(x, y);
-			break;
-		case 1:
-		case 3:
-			// Ghosts 1 and 3 will always try to keep moving in their current
-			// direction if possible
-			if(dirn_options & (1<<curdirn)) {
-				// Current direction is valid - just keep going
-				return curdirn;
-			} else {
-				// Can't move in current direction - try right angles
-				int8_t new_dirn = (curdirn + ghostnum)%4;
-				if(dirn_options & (1 << new_dirn)) {
-					return new_dirn;
-				} else {
-					// Try the other direction at right angles
-					new_dirn = (new_dirn + 2)%4;
-					if(dirn_options & (1 << new_dirn)) {
-						return new_dirn;
-					} else {
-						// Neither of the right angles directions worked
-						// - just go back in the opposite direction 
-						return (curdirn + 2)%4;
-					}
-				}
-			}
-			break;	
-		case 2:
-			// Ghost 2 will try to move in the same direction as the pacman is moving
-			if(dirn_options & (1 << pacman_direction)) {
-				// That direction is one of the valid options
-				return pacman_direction;
-			} else {
-				// Otherwise, start from a random direction and try each in turn
-				int8_t first_direction_to_check = random()%4;
-				for(int8_t i = 0; i < 4; i++) {
-					int8_t direction_to_check = (first_direction_to_check + i)%4;
-					if(dirn_options & (1 << direction_to_check)) {
-						return direction_to_check;
-					
-					}
-				}
-				// Should never get here because one of the directions should be valid
-				// - just indicate that we can't move
-				return -1;
-			}
-	}
-	// Should never get here either - just indicate that we can't move
-	return -1;	
-}
-
-
-// draw_initial_game_field()
-static void draw_initial_game_field(void) {
-	clear_terminal();
-	normal_display_mode();
-	hide_cursor();
-	move_cursor(1,1);	// Start at top left
-	uint16_t wall_array_index = 0;  // row_number * 31 + column_number, i.e. 31*x+y
-	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
-		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
-			char wall_character = pgm_read_byte(&init_game_field[wall_array_index]);
-			switch(wall_character) {
-				case '-':	printf("%s", LINE_HORIZONTAL); break;
-				case '|':	printf("%s", LINE_VERTICAL); break;
-				case 'F':	printf("%s", LINE_DOWN_AND_RIGHT); break;
-				case '7':	printf("%s", LINE_DOWN_AND_LEFT); break;
-				case 'L':	printf("%s", LINE_UP_AND_RIGHT); break;
-				case 'J':	printf("%s", LINE_UP_AND_LEFT); break;
-				case '>':	printf("%s", LINE_VERTICAL_AND_RIGHT); break;
-				case '<':	printf("%s", LINE_VERTICAL_AND_LEFT); break;
-				case '^':	printf("%s", LINE_HORIZONTAL_AND_UP); break;
-				case 'v':	printf("%s", LINE_HORIZONTAL_AND_DOWN); break;
-				case '+':	printf("%s", LINE_VERTICAL_AND_HORIZONTAL); break;
-				case ' ':	printf(" "); break;
-				case 'P':	printf("P"); break;	// power-pellet initially just implemented as a pac-dot
-				case '.':	printf("."); break;	// pac-dot
-				default:	printf("x"); break;	// shouldn't happen but we show an x in case it does
-			}
-			wall_array_index++;
-		}
-		printf("\n");
-	}
-}
-
-static void initialise_pacdots(void) {
-	num_pacdots = 0;
-	uint16_t wall_array_index = 0;  // row_number * 31 + column_number, i.e. 31*x+y
-	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
-		pacdots[y] = 0;
-		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
-			char wall_character = pgm_read_byte(&init_game_field[wall_array_index]);
-			if(wall_character == '.') {
-				pacdots[y] |= (1UL<<x);
-				num_pacdots++;
-			}
-			wall_array_index++;
-		}
-	}	
-}
-
-static void initialise_power_pellets(void) {
-	uint16_t wall_array_index = 0;  // row_number * 31 + column_number, i.e. 31*x+y
-	for(uint8_t y = 0; y < FIELD_HEIGHT; y++) {
-		power_pellets[y] = 0;
-		for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
-			char wall_character = pgm_read_byte(&init_game_field[wall_array_index]);
-			if(wall_character == 'P') {
-				power_pellets[y] |= (1UL<<x);
-				set_display_attribute(BG_CYAN);
-			}
-			wall_array_index++;
-		}
-	}
-}
-
-// Erase the pixel at the given location - presumably because the 
-// ghost or the pac-man has moved out of this space. If there is 
-// still a pac-dot at this space, we output a dot, otherwise we
-// output a space. It is assumed that we are in normal video mode.
-static void erase_pixel_at(uint8_t x, uint8_t y) {
-	move_cursor(x+1, y+1);
-	if(is_pacdot_at(x,y)) {
-		printf(".");
- 	} else if (is_power_pellet_at(x, y)) {
-		printf("P");		 
-	} else {
-		printf(" ");
-	 }
-}
-
-// We draw the pac-man at the given location. The character used
-// to draw the pac-man is based on the direction it is currently
-// facing.
-static void draw_pacman_at(uint8_t x, uint8_t y) {
-	move_cursor(x+1,y+1);
-	set_display_attribute(PACMAN_COLOUR);
-	printf("%s", pacman_characters[pacman_direction]);
-	normal_display_mode();
-}
-
-// ghostnum is assumed to be in the range 0..NUM_GHOSTS-1
-// x and y values are assumed to be valid
-static void draw_ghost_at(uint8_t ghostnum, uint8_t x, uint8_t y) {
-	move_cursor(x+1,y+1);
-	// change the background colour to the colour of the given ghost
-	set_display_attribute(ghost_colours[ghostnum]);
-	// If there is a pac-dot at this location we output a "." otherwise
-	// we output a space (which will be shown as a block in reverse video)
-	if(is_pacdot_at(x,y)) {
-		printf(".");
-	} else if (is_power_pellet_at(x, y)) {
-		printf("P");
-	} else {
-		printf(" ");
-	}
-	// Return to normal display mode to ensure we don't use this
-	// background colour for any other printing
-	normal_display_mode();
-}
-
-/////////////////////////////////////////////////////////////////////////
-/////////////////////////////////////////////////////////////////////////
-// Public Functions
-void initialise_game_level(void) {
-	draw_initial_game_field();
-	initialise_pacdots();
-	initialise_power_pellets();
-	pacman_x = INIT_PACMAN_X;
-	pacman_y = INIT_PACMAN_Y;
-	pacman_direction = INIT_PACMAN_DIRN;
-	draw_pacman_at(pacman_x, pacman_y);
-	for(int8_t i = 0; i < NUM_GHOSTS; i++) {
-		ghost_x[i] = GHOST_HOME_X_LEFT + 2*i;
-		ghost_y[i] = GHOST_HOME_Y;
-		ghost_direction[i] = INIT_GHOST_DIRN;
-		draw_ghost_at(i, ghost_x[i], ghost_y[i]);
-	}
-}
-
-void initialise_game(void) {
-	initialise_game_level();
-	// Initialise Life Display
-	display_lives();
-	game_running = 1;
-}
-
-void determine_ghost_score(int8_t number) {
-	switch(number) {
-		case 1:
-			add_to_score(200);
-			break;
-		case 2:
-			add_to_score(400);
-			break;
-		case 3:
-			add_to_score(800);
-			break;
-		case 4:
-			add_to_score(1600);
-			break;		
-	}
-	display_score();
-}
-
-int8_t move_pacman(void) {
-	if(!game_running) {
-		// Game is over - do nothing
-		return 0;
-	}
-	// If the pac-man is about to exit through the end of a passage-way
-	// then wrap its location around to the other side of the game field
-	// YOUR CODE HERE - you may need to alter the code below also
-	
-	// Work out what is in the direction we want to move
-	int8_t cell_contents = what_is_in_dirn(pacman_x, pacman_y, pacman_direction);
-	if(cell_contents == CELL_IS_WALL) {
-		return 0;	// We can't move - wall is straight ahead
-	}
-	// We can move - erase the pac-man in the current location
-	erase_pixel_at(pacman_x, pacman_y);
-	// Update the pac-man location
-	if(pacman_direction == DIRN_LEFT) {
-		pacman_x--;
-		if(pacman_x == 0) {
-			pacman_x = FIELD_WIDTH - 1;
-		}
-	} else if(pacman_direction == DIRN_RIGHT) {
-		pacman_x++;
-		if(pacman_x == FIELD_WIDTH - 1) {
-			pacman_x = 0;
-		}
-	} else if(pacman_direction == DIRN_UP) {
-		pacman_y--;
-	} else {
-		pacman_y++;
-	}
-	if(cell_contents >= 0) {
-		// We've encountered a ghost - draw both at the location
-		// Set the background colour to that of the ghost
-		// before we print out the pac-man
-		// Note that the variable cell_contents contains the ghost number
-		// Lose a life
-		if (power_active) {
-			ghost_x[cell_contents] = GHOST_HOME_X_LEFT;
-			ghost_y[cell_contents] = GHOST_HOME_Y;
-			ghost_kills++;
-			determine_ghost_score(ghost_kills);
-			disabled_ghosts[cell_contents] = cell_contents;
-			draw_pacman_at(pacman_x, pacman_y);
-		} else {
-			lives--;
-			// Update Life Display
-			display_lives();
-			// Check if pacman still has lives
-			if(lives > 0) {
-				reset_entities_pos();
-				} else {
-				set_display_attribute(ghost_colours[cell_contents]);
-				draw_pacman_at(pacman_x, pacman_y);
-				game_running = 0;
-			}
-		}
-	} else {
-		if(cell_contents == CELL_CONTAINS_PACDOT) {
-			eat_pacdot();
-		} else if (cell_contents == CELL_CONTAINS_POWER_PELLET) {
-			eat_power_pellet();
-		}
-	}
-	draw_pacman_at(pacman_x, pacman_y);
-	return 1;
-}
-
-void reset_entities_pos(void) {
-	// Reset Pacman
-	pacman_x = INIT_PACMAN_X;
-	pacman_y = INIT_PACMAN_Y;
-	// Reset Ghosts
-	for(int8_t i = 0; i < NUM_GHOSTS; i++) {
-		ghost_x[i] = GHOST_HOME_X_LEFT;
-		ghost_y[i] = GHOST_HOME_Y;
-	}
-}
-
-int8_t change_pacman_direction(int8_t direction) {
-	if(!game_running) {
-		// Game is over - do nothing
-		return 0;
-	}
-	// Work out what is in the direction we want to move
-	int8_t cell_contents = what_is_in_dirn(pacman_x, pacman_y, direction);
-	if(cell_contents == CELL_IS_WALL) {
-		// Can't move
-		return 0;
-	} else {
-		pacman_direction = direction;
-		// Redraw the pacman so it is facing in the right direction
-		draw_pacman_at(pacman_x, pacman_y);
-		return 1;
-	}
-}
-
-void move_ghost(int8_t ghostnum) {
-	if(!game_running) {
-		// Game is over - do nothing
-		return;
-	}
-	if(disabled_ghosts[ghostnum] == ghostnum) {
-		// Ghost has been eaten - do nothing
-		return;
-	}
-	int8_t dirn_to_move = determine_ghost_direction_to_move(ghostnum);
-	if(dirn_to_move < 0) {
-		// Ghost can't move (e.g. boxed in) - do nothing
-		return;
-	}
-	
-	// Erase the ghost from the current location
-	erase_pixel_at(ghost_x[ghostnum], ghost_y[ghostnum]);
-	
-	// Update the ghost's direction (it's possible this may be the same value)
-	ghost_direction[ghostnum] = dirn_to_move;
-	// Update the ghost's location
-	switch(dirn_to_move) {
-		case DIRN_LEFT:
-			ghost_x[ghostnum]--;
-			break;
-		case DIRN_RIGHT:
-			ghost_x[ghostnum]++;
-			break;
-		case DIRN_UP:
-			ghost_y[ghostnum]--;
-			break;
-		case DIRN_DOWN:
-			ghost_y[ghostnum]++;
-			break;
-	}
-	
-	// Check if the pac-man is at this ghost location. 
-	if(is_pacman_at(ghost_x[ghostnum], ghost_y[ghostnum])) {
-		if (power_active) {
-			ghost_x[ghostnum] = GHOST_HOME_X_LEFT;
-			ghost_y[ghostnum] = GHOST_HOME_Y;
-			ghost_kills++;
-			determine_ghost_score(ghost_kills);
-			disabled_ghosts[ghostnum] = ghostnum;
-		} else {
-			// Update Lives
-			lives--;
-			// Update Life Display
-			display_lives();
-			// Check if pacman still has lives
-			if(lives > 0) {
-				reset_entities_pos();
-			} else {
-			game_running = 0;
-			set_display_attribute(ghost_colours[ghostnum]);
-			draw_pacman_at(ghost_x[ghostnum], ghost_y[ghostnum]);
-			}
-		}
-	} else {
-		draw_ghost_at(ghostnum, ghost_x[ghostnum], ghost_y[ghostnum]);
-	}
-	normal_display_mode();
-}
-
-int8_t is_game_over(void) {
-	return !game_running;
-}
-
-int8_t is_level_complete(void) {
-	return (num_pacdots == 0);
-}
-
-
-
+/*
+** game.c
+**
+** Author: Peter Sutton
+**
+*/
+
+#include "game.h"
+#include "score.h"
+#include <stdio.h>
+#include "ledmatrix.h"
+#include "terminalio.h"
+#include "pixel_colour.h"
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include <string.h>
+#include "maze_tables.h"
+#include "ports.h"
+#include "level_pack.h"
+#include "prng.h"
+#include "crc16.h"
+#include "rle.h"
+#include "maze_view.h"
+
+/* Stdlib needed for abs() */
+
+///////////////////////////////////////////////////////////
+// Levels
+// The maze for each level (walls, initial positions of the pac-dots and
+// power pellets, where the pac-man and ghosts start, ...) comes from
+// maze_tables.h which is generated from the files in levels/ by the maze
+// compiler (tools/mazec.c). See maze.h for details.
+#if LEVELS_MAX_WIDTH > MAX_FIELD_WIDTH || LEVELS_MAX_HEIGHT > MAX_FIELD_HEIGHT
+#error "A level is larger than MAX_FIELD_WIDTH by MAX_FIELD_HEIGHT"
+#endif
+#if RLE_MAX_LENGTH((LEVELS_MAX_DOT_CELLS + 7) / 8) > GAME_PACKED_DOTS_SIZE
+#error "A level has too many pac-dots for GAME_PACKED_DOTS_SIZE"
+#endif
+
+// State of the game - everything that changes as the game is played (see
+// GameState in game.h). Everything else below is either fixed for the level
+// or worked out from this, so the whole game can be saved and restored as
+// one block (see game_snapshot()).
+static GameState state;
+
+// Details of the level being played (copied from the levels table)
+static LevelData level;
+
+// Size of the game field for the level being played
+uint8_t field_width;
+uint8_t field_height;
+// Number of words (bytes) used for each row of the field's bitboards
+static uint8_t field_row_words;
+
+// Array to store the game dots (state.pacdots) - each element in the array is a row
+// of bits (see bitboard.h), representing the absence/presence of pacdots in each
+// row. The first element in the array is for row 0 (top), the last used element
+// for row field_height - 1 (bottom).
+// Bit 0 of a row is the value for column 0 (left hand column), bit field_width - 1
+// is for the right hand column. Bits beyond that are unused. A value of 1 in a bit
+// represents the presence of a pacdot, 0 is the absence.
+//
+
+// Walls - same layout as the pacdots array, bit x of row y is 1 if there is a
+// wall at (x,y). The unused bits beyond the end of each row are set too (as if
+// there was a wall just outside the field) so that the non-wall cells of a row
+// are just the inverse of its walls. Unpacked from the level's maze when the
+// level starts.
+static uint8_t walls[MAX_FIELD_HEIGHT][FIELD_ROW_WORDS];
+
+// We also keep a count of the number of pac-dots remaining on each row and
+// on the whole game field. These only change when a row of the pacdots
+// array does (see count_pacdots_in_row()) so they always agree with it.
+static uint8_t pacdot_row_count[MAX_FIELD_HEIGHT];
+static uint16_t num_pacdots;
+
+// Rows whose pac-dots or power pellets have changed since
+// game_clear_changed_rows() (bit y for row y - see game.h)
+#if MAX_FIELD_HEIGHT > 32
+#error "changed_rows has a bit for each row - MAX_FIELD_HEIGHT must be 32 or less"
+#endif
+static uint32_t changed_rows;
+
+// Initial direction of the ghosts (their location is the level's ghost home)
+#define INIT_GHOST_DIRN DIRN_RIGHT
+
+// Values to represent the contents of a cell (x,y)
+// Non-negative values are used for ghost numbers (0 to num_ghosts - 1)
+#define CELL_IS_GHOST_HOME (-1)
+#define CELL_IS_WALL (-2)
+#define CELL_CONTAINS_PACMAN (-3)
+#define CELL_CONTAINS_PACDOT (-4)
+#define CELL_EMPTY (-5)
+#define CELL_CONTAINS_POWER_PELLET (-6)
+
+// Maximum Pacman Lives
+#define MAX_LIVES (3)
+// LED Display Value 
+static int8_t lives_led = 7;
+
+// Ghost behaviours - the way a ghost chooses which direction to move in
+// when it isn't frightened. Each is an index into ghost_behaviours (below).
+#define GHOST_BEHAVIOUR_CHASE 0			// move towards the pac-man
+#define GHOST_BEHAVIOUR_TURN_RIGHT 1	// keep going, turn right at walls
+#define GHOST_BEHAVIOUR_FOLLOW 2		// move the same way as the pac-man
+#define GHOST_BEHAVIOUR_TURN_LEFT 3		// keep going, turn left at walls
+#define NUM_GHOST_BEHAVIOURS 4
+
+// Details of each ghost that can be in play. Ghost i (0 to num_ghosts - 1)
+// takes its behaviour, speed (milliseconds between moves) and colour from
+// entry i of this table. The first four are the original ghosts. There is
+// an entry for each of the 16 ghosts MAX_GHOSTS allows (see game.h) - only
+// the first MAX_GHOSTS of them are used.
+typedef struct {
+	uint8_t behaviour;
+	uint16_t move_period;
+	uint8_t colour;
+} GhostDefinition;
+
+static const GhostDefinition ghost_definitions[] PROGMEM = {
+	{ GHOST_BEHAVIOUR_CHASE, 400, BG_RED },
+	{ GHOST_BEHAVIOUR_TURN_RIGHT, 500, BG_GREEN },
+	{ GHOST_BEHAVIOUR_FOLLOW, 550, BG_CYAN },
+	{ GHOST_BEHAVIOUR_TURN_LEFT, 600, BG_MAGENTA },
+	{ GHOST_BEHAVIOUR_CHASE, 450, BG_YELLOW },
+	{ GHOST_BEHAVIOUR_TURN_LEFT, 500, BG_WHITE },
+	{ GHOST_BEHAVIOUR_FOLLOW, 450, BG_RED },
+	{ GHOST_BEHAVIOUR_TURN_RIGHT, 550, BG_GREEN },
+	{ GHOST_BEHAVIOUR_CHASE, 500, BG_CYAN },
+	{ GHOST_BEHAVIOUR_TURN_RIGHT, 450, BG_MAGENTA },
+	{ GHOST_BEHAVIOUR_FOLLOW, 500, BG_YELLOW },
+	{ GHOST_BEHAVIOUR_TURN_LEFT, 450, BG_WHITE },
+	{ GHOST_BEHAVIOUR_CHASE, 550, BG_RED },
+	{ GHOST_BEHAVIOUR_TURN_LEFT, 400, BG_GREEN },
+	{ GHOST_BEHAVIOUR_FOLLOW, 600, BG_CYAN },
+	{ GHOST_BEHAVIOUR_TURN_RIGHT, 400, BG_MAGENTA },
+};
+_Static_assert(sizeof(ghost_definitions) / sizeof(ghost_definitions[0])
+		>= MAX_GHOSTS, "every ghost needs an entry in ghost_definitions");
+
+// Each ghost's behaviour and number of ticks between moves (from its
+// definition, with the period scaled for the level)
+static uint8_t ghost_behaviour[MAX_GHOSTS];
+static uint8_t ghost_move_ticks[MAX_GHOSTS];
+
+// Number of ticks between moves of the pac-man on this level
+static uint8_t pacman_move_ticks;
+
+// Number of ticks in a period (in milliseconds) - rounded up, since a move
+// that is due part way through a tick happens at the end of it. Periods
+// must be less than 256 ticks (2.56 seconds) since the times of the last
+// moves are only kept to 8 bits (see GameState in game.h).
+#define PERIOD_TICKS(period) (((period) + GAME_TICK_MS - 1) / GAME_TICK_MS)
+
+// Cells that contain (at least) one ghost - same layout as the pacdots array.
+// This lets us check a cell for ghosts without looking at every ghost. The
+// eyes of eaten ghosts are not included.
+static uint8_t ghost_occupied[MAX_FIELD_HEIGHT][FIELD_ROW_WORDS];
+
+// Distance from the pac-man to every cell, used by frightened ghosts to pick
+// a way to go that takes them further away. Rather than storing the distance
+// itself we store (distance % 3) + 1 for each cell in two bit planes that use
+// the same layout as the pacdots array (bit 0 of the label in distance_lo,
+// bit 1 in distance_hi). A label of 0 means the cell hasn't been reached.
+// Adjacent cells always differ in distance by exactly one, so comparing the
+// labels of two neighbours is enough to tell which is further away.
+// The field is worked out (one breadth first search, shared by all ghosts)
+// only when a frightened ghost needs it after the pac-man has moved, and only
+// out to FLEE_SEARCH_DEPTH moves from the pac-man.
+static uint8_t distance_lo[MAX_FIELD_HEIGHT][FIELD_ROW_WORDS];
+static uint8_t distance_hi[MAX_FIELD_HEIGHT][FIELD_ROW_WORDS];
+static uint8_t distance_field_valid;
+
+// How far (in moves) the distance field search goes out from the pac-man.
+// This caps the work done each time the pac-man moves - ghosts further away
+// than this aren't in any hurry and just move away in a straight line.
+#define FLEE_SEARCH_DEPTH 12
+
+#define PACMAN_COLOUR (FG_YELLOW)
+#define FRIGHTENED_GHOST_COLOUR (BG_BLUE)
+#define GHOST_EYES_COLOUR (FG_WHITE)
+#define GHOST_EYES_CHARACTER "\""
+
+// Unicode characters used to represent the pacman in each direction
+static const char* pacman_characters[NUM_DIRECTION_VALUES] = {
+	"\u15E4", "\u15E2", "\u15E7", "\u15E3"
+};
+
+
+///////////////////////////////////////////////////////////
+// Private Functions
+//
+// is_wall_at() returns true (1) if there is a wall at the given 
+// game location, 0 otherwise
+static int8_t is_wall_at (uint8_t x, uint8_t y) {
+	return bitboard_test(walls[y], x) != 0;
+}
+
+// Returns the directions that aren't blocked by a wall (or the edge of the
+// field) from (x,y) - bit d is set if direction d is open
+static uint8_t exits_at(uint8_t x, uint8_t y) {
+	uint8_t exits = 0;
+	if(x > 0 && !is_wall_at(x - 1, y)) {
+		exits |= (1 << DIRN_LEFT);
+	}
+	if(y > 0 && !is_wall_at(x, y - 1)) {
+		exits |= (1 << DIRN_UP);
+	}
+	if(x < field_width - 1 && !is_wall_at(x + 1, y)) {
+		exits |= (1 << DIRN_RIGHT);
+	}
+	if(y < field_height - 1 && !is_wall_at(x, y + 1)) {
+		exits |= (1 << DIRN_DOWN);
+	}
+	return exits;
+}
+
+void display_score(void) {
+	move_cursor(50,20);
+	printf_P(PSTR("Score /n %d /n High Score /n %d"), 1.0, "Score", get_score(), "High Score", get_highscore());
+}
+
+// is_pacman_at() returns true(1) if the pacman is at the given 
+// game location (x,y), 0 otherwise
+static int8_t is_pacman_at(uint8_t x, uint8_t y) {
+	return (x == state.pacman_x && y == state.pacman_y);
+}
+
+// ghost_at() returns the number of a ghost at the given game location
+// (x,y), or -1 if there isn't one. ghost_occupied tells us straight away
+// whether there is a ghost there - we only need to look through the ghosts
+// to find out which one it is if there is.
+static int8_t ghost_at(uint8_t x, uint8_t y) {
+	if(!bitboard_test(ghost_occupied[y], x)) {
+		return -1;
+	}
+	for(int8_t i = 0; i < state.num_ghosts; i++) {
+		if(x == state.ghost_x[i] && y == state.ghost_y[i]
+				&& state.ghost_state[i] != GHOST_STATE_EYES) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// A ghost (not eyes) has arrived at the given location
+static void add_ghost_occupied(uint8_t x, uint8_t y) {
+	bitboard_set(ghost_occupied[y], x);
+}
+
+// A ghost has left the given location (or turned into eyes) - the cell is
+// still occupied if another ghost is there too (e.g. in the ghost home).
+static void remove_ghost_occupied(uint8_t x, uint8_t y) {
+	bitboard_clear(ghost_occupied[y], x);
+	for(int8_t i = 0; i < state.num_ghosts; i++) {
+		if(x == state.ghost_x[i] && y == state.ghost_y[i]
+				&& state.ghost_state[i] != GHOST_STATE_EYES) {
+			add_ghost_occupied(x, y);
+			return;
+		}
+	}
+}
+
+// Work out ghost_occupied from scratch (e.g. after the ghosts are reset)
+static void initialise_ghost_occupied(void) {
+	memset(ghost_occupied, 0, sizeof(ghost_occupied));
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		if(state.ghost_state[i] != GHOST_STATE_EYES) {
+			add_ghost_occupied(state.ghost_x[i], state.ghost_y[i]);
+		}
+	}
+}
+
+// is_pacdot_at() returns true (1) if there is a pacdot at the given
+// game location, 0 otherwise
+static int8_t is_pacdot_at (uint8_t x, uint8_t y) {
+	// Extract the value for the column x (which is in bit x of row y)
+	if(bitboard_test(state.pacdots[y], x)) {
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+// Work out the number of pac-dots on row y again after the row has changed
+// and update the total to match
+static void count_pacdots_in_row(uint8_t y) {
+	changed_rows |= (uint32_t)1 << y;
+	num_pacdots -= pacdot_row_count[y];
+	pacdot_row_count[y] = bitboard_popcount(state.pacdots[y], field_row_words);
+	num_pacdots += pacdot_row_count[y];
+}
+
+// is_power_pellet_at() returns true (1) if there is a power pellet at the given
+// game location, 0 otherwise
+static int8_t is_power_pellet_at (uint8_t x, uint8_t y) {
+	// Extract the value for the column x (which is in bit x of row y)
+	if(bitboard_test(state.power_pellets[y], x)) {
+		return 1;
+		} else {
+		return 0;
+	}
+}
+
+// Returns true (1) if the given location is the home of the ghosts
+// (this includes the entry to the home of the ghosts)
+static int8_t is_ghost_home(uint8_t x, uint8_t y) {
+	if(y == level.ghost_home_y && x >= level.ghost_home_x_left
+			&& x <= level.ghost_home_x_right) {
+		return 1;
+	} else if(y == level.ghost_home_entry_y && x >= level.ghost_home_entry_x_left
+			&& x <= level.ghost_home_entry_x_right) {
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+static void display_no_dots(void) {
+	move_cursor(50,10);
+	printf_P(PSTR("Number of Pacdots : %d"), num_pacdots);
+}
+
+// The pac-man has just arrived in a location occupied by a pac-dot. Update
+// our array which keeps track of remaining pacdots. Update and output the
+// count of remaining pac-dots.
+// See initialise_game_field() below for information on how the pacdots array
+// is initialised.
+static void eat_pacdot(void) {
+	// Update Location to Contain No Dot
+	bitboard_clear(state.pacdots[state.pacman_y], state.pacman_x);
+	// Update Number of Pacdots
+	count_pacdots_in_row(state.pacman_y);
+	// Update Current Score
+	add_to_score(10);
+	display_score();
+	display_no_dots();
+}
+
+// The pac-man has just arrived in a location occupied by a power pellet. Update
+// our array which keeps track of remaining power pellets.
+// See initialise_game_field() below for information on how the power pellet array
+// is initialised.
+static void eat_power_pellet(void) {
+	if (state.power_active) {
+		state.ghost_kills = 0;
+	}
+	state.power_active = 1;
+	// Update Location to Contain No Dot
+	bitboard_clear(state.power_pellets[state.pacman_y], state.pacman_x);
+	changed_rows |= (uint32_t)1 << state.pacman_y;
+	// Update Current Score
+	add_to_score(50);
+	display_score();
+	for (int8_t i = 0; i < state.num_ghosts; i++) {
+		if(state.ghost_state[i] != GHOST_STATE_EYES) {
+			state.ghost_state[i] = GHOST_STATE_FRIGHTENED;
+		}
+	}
+	state.powered_period = get_game_time();
+}
+
+static void display_lives(void) {
+	switch(state.lives) {
+		case 0:
+			lives_led = 0;
+			break;
+		case 1:
+			lives_led = 1;
+			break;
+		case 2:
+			lives_led = 3;
+			break;
+		case 3:
+			lives_led = 7;
+			break;
+	}
+	ports_write(IO_PORT_C, LIVES_LED_PINS, lives_led);
+}
+
+// what_is_at(x,y) returns
+//		CELL_EMPTY, CELL_CONTAINS_PACDOT, CELL_CONTAINS_POWER_PELLET,
+//		CELL_CONTAINS_PACMAN, CELL_IS_WALL, CELL_IS_GHOST_HOME or the ghost
+//		number if the cell contains a ghost (eyes of eaten ghosts are ignored)
+int8_t what_is_at(uint8_t x, uint8_t y) {
+	if(is_pacman_at(x,y)) {
+		return CELL_CONTAINS_PACMAN;
+	} else { // Check for ghosts next - these take priority over dots
+		// BUT note that there may be a pacdot at the same location
+		// Eyes of eaten ghosts don't occupy a cell - they pass over everything
+		int8_t ghostnum = ghost_at(x,y);
+		if(ghostnum >= 0) {
+			return ghostnum;
+		}
+	}
+	if (is_pacdot_at(x,y)) {
+		return CELL_CONTAINS_PACDOT;
+	} else if (is_power_pellet_at(x,y)) {
+		return CELL_CONTAINS_POWER_PELLET;
+	} else if (is_wall_at(x,y)) {
+		return CELL_IS_WALL;
+	} else if(is_ghost_home(x,y)) {
+		return CELL_IS_GHOST_HOME;
+	}
+	// If we get here, we haven't found anything else - cell is empty
+	return CELL_EMPTY;
+}
+
+// what_is_in_dirn(x,y,direction) returns what is in the cell one from
+// the cell at (x,y) in the given direction - provided that is not off
+// the game field. (If it is, we just indicate that a wall is there.)
+// The walls around the cell tell us straight away if there is a wall (or the
+// edge) in that direction.
+int8_t what_is_in_dirn(uint8_t x, uint8_t y, uint8_t direction) {
+	if(direction > DIRN_DOWN || !(exits_at(x, y) & (1 << direction))) {
+		return CELL_IS_WALL;
+	}
+	switch(direction) {
+		case DIRN_LEFT:
+			x--;
+			break;
+		case DIRN_RIGHT:
+			x++;
+			break;
+		case DIRN_UP:
+			y--;
+			break;
+		case DIRN_DOWN:
+			y++;
+			break;
+	}
+	return what_is_at(x, y);
+}
+
+// determine_dirns_ghost_can_move_in()
+// Returns a number that indicates whether a ghost at the given x,y location
+// can move in each direction. The lower 4 bits of the return value will each
+// be 0 or 1 - 0 means can't move in the direction, 1 means can move. The bit
+// positions are
+// - 0 (DIRN_LEFT) (least significant) - left
+// - 1 (DIRN_RIGHT) - right
+// - 2 (DIRN_UP) - up
+// - 3 (DIRN_DOWN) - down
+// Movement in the given direction can only happen if the cell is one of
+// - the pacman
+// - a pacdot
+// - empty
+// It can not move there if the cell is a ghost or a wall.
+// If we're in the ghost home we can move to another cell in the ghost home.
+// If we're outside the ghost home we can't move into it.
+static int8_t determine_dirns_ghost_can_move_in(uint8_t x, uint8_t y) {
+	int8_t return_value = 0;
+	int8_t posn_is_in_ghost_home = is_ghost_home(x,y);
+	uint8_t exits = exits_at(x,y);
+	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
+		if(!(exits & (1 << dirn))) {
+			continue;	// wall in the way
+		}
+		int8_t adjacent_cell_contents = what_is_in_dirn(x,y,dirn);
+		
+		if(adjacent_cell_contents < CELL_IS_WALL) {
+			// cell is empty or pacdot or pacman
+			return_value |= (1 << dirn);
+		} else if(posn_is_in_ghost_home && adjacent_cell_contents == CELL_IS_GHOST_HOME) {
+			// we're in the ghost home and can move to an empty cell in the ghost home
+			return_value |= (1 << dirn);
+		} 
+	}
+	return return_value;
+}
+
+// Returns the distance label ((distance % 3) + 1, or 0 if not reached) of the
+// given cell. See distance_lo/distance_hi above.
+static uint8_t distance_label_at(uint8_t x, uint8_t y) {
+	uint8_t label = 0;
+	if(bitboard_test(distance_lo[y], x)) {
+		label |= 1;
+	}
+	if(bitboard_test(distance_hi[y], x)) {
+		label |= 2;
+	}
+	return label;
+}
+
+// Sets cells to the cells in row y that have the given distance label
+static void cells_with_distance_label(uint8_t* cells, uint8_t y, uint8_t label) {
+	for(uint8_t w = 0; w < field_row_words; w++) {
+		switch(label) {
+			case 1:
+				cells[w] = distance_lo[y][w] & ~distance_hi[y][w];
+				break;
+			case 2:
+				cells[w] = distance_hi[y][w] & ~distance_lo[y][w];
+				break;
+			default:
+				cells[w] = distance_lo[y][w] & distance_hi[y][w];
+				break;
+		}
+	}
+}
+
+// Returns true (1) if every frightened ghost is on a cell that has been
+// reached by the distance field search
+static int8_t frightened_ghosts_reached(void) {
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		if(state.ghost_state[i] == GHOST_STATE_FRIGHTENED
+				&& distance_label_at(state.ghost_x[i], state.ghost_y[i]) == 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Work out the distance field (see distance_lo/distance_hi above) with a
+// breadth first search out from the pac-man. Each step of the search works
+// on whole rows at once: the cells one further away are the neighbours
+// of the cells labelled in the last step that are open and not yet labelled.
+// No queue or visited array is needed since the labels themselves tell us
+// which cells have been reached. We stop one step after all frightened
+// ghosts have been reached so that their neighbours are labelled too, or
+// after FLEE_SEARCH_DEPTH steps - any open cell left unlabelled is further
+// away than every labelled cell. After d steps only the rows within d of the
+// pac-man can have been reached, so only those rows are searched.
+static void compute_distance_field(void) {
+	memset(distance_lo, 0, sizeof(distance_lo));
+	memset(distance_hi, 0, sizeof(distance_hi));
+	bitboard_set(distance_lo[state.pacman_y], state.pacman_x);	// distance 0 has label 1
+	uint8_t label = 1;
+	uint8_t distance = 0;
+	int8_t steps_remaining = -1;	// -1 until all frightened ghosts reached
+	uint8_t cells_added;
+	// Cells with the current label in the rows above, on and below the row
+	// being searched. The buffers are swapped round as we move down.
+	uint8_t buffers[3][FIELD_ROW_WORDS];
+	do {
+		uint8_t next_label = (label % 3) + 1;
+		uint8_t* row_above = buffers[0];
+		uint8_t* row = buffers[1];
+		uint8_t* row_below = buffers[2];
+		// Rows that can have cells one further away than distance
+		uint8_t first_y = 0;
+		if(state.pacman_y > distance) {
+			first_y = state.pacman_y - distance - 1;
+		}
+		uint8_t last_y = field_height - 1;
+		if(state.pacman_y + distance + 1 < last_y) {
+			last_y = state.pacman_y + distance + 1;
+		}
+		memset(row_above, 0, field_row_words);
+		cells_with_distance_label(row, first_y, label);
+		cells_added = 0;
+		for(uint8_t y = first_y; y <= last_y; y++) {
+			if(y < last_y) {
+				cells_with_distance_label(row_below, y + 1, label);
+			} else {
+				memset(row_below, 0, field_row_words);
+			}
+			// Neighbours above and below (re-using row_above - it isn't
+			// needed again once this row is done)
+			uint8_t* new_cells = row_above;
+			for(uint8_t w = 0; w < field_row_words; w++) {
+				new_cells[w] |= row_below[w];
+			}
+			bitboard_or_horizontal_neighbours(new_cells, row, field_row_words);
+			for(uint8_t w = 0; w < field_row_words; w++) {
+				uint8_t new_word = new_cells[w] & ~walls[y][w]
+						& ~(distance_lo[y][w] | distance_hi[y][w]);
+				if(new_word) {
+					if(next_label & 1) {
+						distance_lo[y][w] |= new_word;
+					}
+					if(next_label & 2) {
+						distance_hi[y][w] |= new_word;
+					}
+					cells_added = 1;
+				}
+			}
+			row_above = row;
+			row = row_below;
+			row_below = new_cells;
+		}
+		label = next_label;
+		distance++;
+		if(steps_remaining < 0 && frightened_ghosts_reached()) {
+			steps_remaining = 1;
+		} else if(steps_remaining > 0) {
+			steps_remaining--;
+		}
+	} while(cells_added && steps_remaining != 0
+			&& distance < FLEE_SEARCH_DEPTH);
+	distance_field_valid = 1;
+}
+
+// direction_away_from_pacman() is called for a frightened ghost and returns
+// a direction to move in that takes the ghost further from the pac-man,
+// based on the distance field (or, if the ghost is beyond the search, the
+// straight line distance). If the ghost is in a dead end (no way further
+// away) any possible direction is returned, turning back only as a last
+// resort. Returns -1 if the ghost can't move.
+static int8_t direction_away_from_pacman(uint8_t x, uint8_t y, uint8_t curdirn,
+		int8_t dirn_options) {
+	if(!distance_field_valid) {
+		// Pac-man has moved - redo the search
+		compute_distance_field();
+	}
+	uint8_t label_here = distance_label_at(x,y);
+	uint8_t further_label = (label_here % 3) + 1;
+	uint8_t distance_here = abs(state.pacman_x - x) + abs(state.pacman_y - y);
+	int8_t further_options = 0;
+	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
+		if(dirn_options & (1 << dirn)) {
+			uint8_t nx = x;
+			uint8_t ny = y;
+			switch(dirn) {
+				case DIRN_LEFT:		nx--; break;
+				case DIRN_RIGHT:	nx++; break;
+				case DIRN_UP:		ny--; break;
+				case DIRN_DOWN:		ny++; break;
+			}
+			if(label_here == 0) {
+				// Beyond the search - just use the straight line distance
+				if(abs(state.pacman_x - nx) + abs(state.pacman_y - ny)
+						> distance_here) {
+					further_options |= (1 << dirn);
+				}
+			} else {
+				uint8_t label = distance_label_at(nx, ny);
+				// Unlabelled cells are beyond the search so are further away
+				if(label == further_label || label == 0) {
+					further_options |= (1 << dirn);
+				}
+			}
+		}
+	}
+	if(further_options == 0) {
+		// Nowhere further away - try anything but turning back
+		further_options = dirn_options & ~(1 << ((curdirn + 2) % 4));
+		if(further_options == 0) {
+			further_options = dirn_options;
+		}
+	}
+	if(further_options & (1 << curdirn)) {
+		// Keep going the same way if we can
+		return curdirn;
+	}
+	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
+		if(further_options & (1 << dirn)) {
+			return dirn;
+		}
+	}
+	// We can't move in any direction
+	return -1;
+}
+
+// direction_to_pacman() is called for a ghost position and we return a direction
+// to move in that will take us closer to the pacman (from DIRN_LEFT to DIRN_DOWN)
+// or -1 if we can't move at all. (Note we can only move into cells that are empty
+// OR contain a pacdot OR contain the pacman. We can't move into walls or cells 
+// that contain ghosts.)
+static int8_t direction_to_pacman(uint8_t x, uint8_t y) {
+	int8_t delta_x = state.pacman_x - x;
+	int8_t delta_y = state.pacman_y - y;
+	// Work out which direction options are possible
+	int8_t dirn_options = determine_dirns_ghost_can_move_in(x, y);
+	if(dirn_options == 0) {
+		// Can't move
+		return -1;
+	}
+	
+	if(abs(delta_x) < abs(delta_y)) {
+		// Pacman is further away in y direction - try this direction (up/down) first
+		if(delta_y < 0) {
+			if(dirn_options & (1 << DIRN_UP)) {
+				return DIRN_UP;
+			}
+			// Can't move up - move on to checking left/right
+		} else if(delta_y > 0) {
+			if(dirn_options & (1 << DIRN_DOWN)) {
+				return DIRN_DOWN;
+			}
+			// Can't move down - move on to checking left/right
+		} // else delta_y is 0 - so try left/right
+	}
+	// Try the x direction 
+	if(delta_x < 0) {
+		if(dirn_options & (1 << DIRN_LEFT)) {
+			return DIRN_LEFT;
+		}
+		// Pacman is left but we can't move left - try up or down
+		if(delta_y < 0) {
+			if(dirn_options & (1 << DIRN_UP)) {
+				return DIRN_UP;
+			}
+		} else if(dirn_options & (1 << DIRN_DOWN)) {
+			return DIRN_DOWN;
+		}
+	} else {
+		if(dirn_options & (1 << DIRN_RIGHT)) {
+			return DIRN_RIGHT;
+		}
+		// Pacman is right (or directly above/below) but we can't move right - try up or down
+		if(delta_y < 0) {
+			if(dirn_options & (1 << DIRN_UP)) {
+				return DIRN_UP;
+			} 
+		} else if(dirn_options & (1 << DIRN_DOWN)) {
+			return DIRN_DOWN;
+		}
+	}
+	// Just move whichever way we can - try until we find one that works
+	for(int8_t dirn = DIRN_LEFT; dirn <= DIRN_DOWN; dirn++) {
+		if(dirn_options & (1 << dirn)) {
+			return dirn;
+		}
+	}
+	// We can't move in any direction
+	return -1;
+}
+
+// Ghost behaviours
+// Each of these is given a ghost number and the directions that ghost can
+// move in (see determine_dirns_ghost_can_move_in() - there is at least one)
+// and returns the direction the ghost should move in, or -1 if it can't move.
+typedef int8_t (*GhostBehaviour)(uint8_t ghostnum, int8_t dirn_options);
+
+// Always try to move towards the pac-man
+static int8_t chase_pacman(uint8_t ghostnum, int8_t dirn_options) {
+	return direction_to_pacman(state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+}
+
+// Try to keep moving in the current direction. If that isn't possible, try
+// the direction we get by turning (turn is 1 for right, 3 for left), then
+// the opposite way, then go back the way we came.
+static int8_t keep_going(uint8_t ghostnum, int8_t dirn_options, uint8_t turn) {
+	uint8_t curdirn = state.ghost_direction[ghostnum];
+	if(dirn_options & (1<<curdirn)) {
+		// Current direction is valid - just keep going
+		return curdirn;
+	}
+	// Can't move in current direction - try right angles
+	int8_t new_dirn = (curdirn + turn)%4;
+	if(dirn_options & (1 << new_dirn)) {
+		return new_dirn;
+	}
+	// Try the other direction at right angles
+	new_dirn = (new_dirn + 2)%4;
+	if(dirn_options & (1 << new_dirn)) {
+		return new_dirn;
+	}
+	// Neither of the right angles directions worked
+	// - just go back in the opposite direction
+	return (curdirn + 2)%4;
+}
+
+static int8_t keep_going_turn_right(uint8_t ghostnum, int8_t dirn_options) {
+	return keep_going(ghostnum, dirn_options, 1);
+}
+
+static int8_t keep_going_turn_left(uint8_t ghostnum, int8_t dirn_options) {
+	return keep_going(ghostnum, dirn_options, 3);
+}
+
+// Try to move in the same direction as the pacman is moving
+static int8_t follow_pacman_direction(uint8_t ghostnum, int8_t dirn_options) {
+	if(dirn_options & (1 << state.pacman_direction)) {
+		// That direction is one of the valid options
+		return state.pacman_direction;
+	}
+	// Otherwise, start from a random direction and try each in turn
+	int8_t first_direction_to_check = prng_next8()%4;
+	for(int8_t i = 0; i < 4; i++) {
+		int8_t direction_to_check = (first_direction_to_check + i)%4;
+		if(dirn_options & (1 << direction_to_check)) {
+			return direction_to_check;
+		}
+	}
+	// Should never get here because one of the directions should be valid
+	// - just indicate that we can't move
+	return -1;
+}
+
+// The behaviours above, indexed by the GHOST_BEHAVIOUR_ values. Stored in
+// program memory - use pgm_read_ptr() to get the function pointer.
+static const GhostBehaviour ghost_behaviours[NUM_GHOST_BEHAVIOURS] PROGMEM = {
+	chase_pacman,
+	keep_going_turn_right,
+	follow_pacman_direction,
+	keep_going_turn_left
+};
+
+// determine_ghost_direction_to_move()
+// 
+// Determine the direction the given ghost should move in.
+// (Each ghost uses the behaviour it was given in ghost_definitions.)
+// Return -1 if the ghost can't move (e.g. surrounded by walls and other
+// ghosts).
+static int8_t determine_ghost_direction_to_move(uint8_t ghostnum) {
+	uint8_t x = state.ghost_x[ghostnum];
+	uint8_t y = state.ghost_y[ghostnum];
+
+	int8_t dirn_options = determine_dirns_ghost_can_move_in(x,y);
+	if(dirn_options == 0) {
+		// ghost has no options - indicate that the ghost can't move
+		return -1;
+	}
+	
+	if(is_ghost_home(x,y)) {
+		// Attempt to move ghost out of home - try UP
+		if(dirn_options & (1 << DIRN_UP)) {
+			return DIRN_UP;
+		}
+		// If this doesn't work, we'll try the usual algorithm
+	}
+	if(state.ghost_state[ghostnum] == GHOST_STATE_FRIGHTENED) {
+		// All frightened ghosts behave the same way - run away
+		return direction_away_from_pacman(x, y, state.ghost_direction[ghostnum],
+				dirn_options);
+	}
+	GhostBehaviour behaviour = (GhostBehaviour)pgm_read_ptr(
+			&ghost_behaviours[ghost_behaviour[ghostnum]]);
+	return behaviour(ghostnum, dirn_options);
+}
+
+
+// Erase the pixel at the given location - presumably because the 
+// ghost or the pac-man has moved out of this space. If there is 
+// still a pac-dot at this space, we output a dot, otherwise we
+// output a space. It is assumed that we are in normal video mode.
+static void erase_pixel_at(uint8_t x, uint8_t y) {
+	maze_view_cell_changed(x, y);
+	move_cursor(x+1, y+1);
+	if(is_pacdot_at(x,y)) {
+		printf(".");
+ 	} else if (is_power_pellet_at(x, y)) {
+		printf("P");		 
+	} else {
+		printf(" ");
+	 }
+}
+
+// We draw the pac-man at the given location. The character used
+// to draw the pac-man is based on the direction it is currently
+// facing.
+static void draw_pacman_at(uint8_t x, uint8_t y) {
+	maze_view_cell_changed(x, y);
+	move_cursor(x+1,y+1);
+	set_display_attribute(PACMAN_COLOUR);
+	printf("%s", pacman_characters[state.pacman_direction]);
+	normal_display_mode();
+}
+
+// Returns the colour the given ghost is drawn in (its own colour unless
+// it is frightened)
+static uint8_t ghost_colour(uint8_t ghostnum) {
+	if(state.ghost_state[ghostnum] == GHOST_STATE_FRIGHTENED) {
+		return FRIGHTENED_GHOST_COLOUR;
+	}
+	return pgm_read_byte(&ghost_definitions[ghostnum].colour);
+}
+
+// ghostnum is assumed to be in the range 0..num_ghosts-1
+// x and y values are assumed to be valid
+static void draw_ghost_at(uint8_t ghostnum, uint8_t x, uint8_t y) {
+	maze_view_cell_changed(x, y);
+	move_cursor(x+1,y+1);
+	// change the background colour to the colour of the given ghost
+	set_display_attribute(ghost_colour(ghostnum));
+	// If there is a pac-dot at this location we output a "." otherwise
+	// we output a space (which will be shown as a block in reverse video)
+	if(is_pacdot_at(x,y)) {
+		printf(".");
+	} else if (is_power_pellet_at(x, y)) {
+		printf("P");
+	} else {
+		printf(" ");
+	}
+	// Return to normal display mode to ensure we don't use this
+	// background colour for any other printing
+	normal_display_mode();
+}
+
+// Draw the eyes of an eaten ghost (on its way home) at the given location
+static void draw_eyes_at(uint8_t x, uint8_t y) {
+	maze_view_cell_changed(x, y);
+	move_cursor(x+1,y+1);
+	set_display_attribute(GHOST_EYES_COLOUR);
+	printf("%s", GHOST_EYES_CHARACTER);
+	normal_display_mode();
+}
+
+// Redraw whatever should be shown at the given location - used when a pair
+// of eyes moves out of a cell that may also hold the pac-man or a ghost.
+static void redraw_cell_at(uint8_t x, uint8_t y) {
+	int8_t cell_contents = what_is_at(x,y);
+	if(cell_contents == CELL_CONTAINS_PACMAN) {
+		draw_pacman_at(x,y);
+	} else if(cell_contents >= 0) {
+		draw_ghost_at(cell_contents, x, y);
+	} else {
+		erase_pixel_at(x,y);
+	}
+}
+
+// Draw every ghost (or its eyes) and then the pac-man where they are now
+static void draw_pacman_and_ghosts(void) {
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		if(state.ghost_state[i] != GHOST_STATE_EYES) {
+			draw_ghost_at(i, state.ghost_x[i], state.ghost_y[i]);
+		} else if(!is_pacman_at(state.ghost_x[i], state.ghost_y[i])) {
+			draw_eyes_at(state.ghost_x[i], state.ghost_y[i]);
+		}
+	}
+	draw_pacman_at(state.pacman_x, state.pacman_y);
+}
+
+// Unpack the level's maze (see maze.h) - a row at a time straight into
+// the walls array and out to the terminal. If start_of_level is true the
+// pac-dots and power pellets are set from the maze too. Otherwise they are
+// left as they are (e.g. a restored game) and the ones shown in the maze
+// that are no longer there are erased again as each row is output.
+static void initialise_game_field(uint8_t start_of_level) {
+	uint8_t level_pacdots[FIELD_ROW_WORDS];
+	uint8_t level_power_pellets[FIELD_ROW_WORDS];
+	clear_terminal();
+	normal_display_mode();
+	hide_cursor();
+	maze_view_field_changed();
+	move_cursor(1,1);	// Start at top left
+	memset(walls, 0xFF, sizeof(walls));
+	// The pac-dots and power pellets are new (or may be)
+	changed_rows = 0xFFFFFFFF;
+	if(start_of_level) {
+		memset(state.pacdots, 0, sizeof(state.pacdots));
+		memset(state.power_pellets, 0, sizeof(state.power_pellets));
+	}
+	num_pacdots = 0;
+	PackReader reader;
+	pack_reader_start(&reader, level.maze);
+	for(uint8_t y = 0; y < field_height; y++) {
+		// The row is cleared first so the bits beyond the end stay set
+		for(uint8_t x = 0; x < field_width; x++) {
+			bitboard_clear(walls[y], x);
+		}
+		memset(level_pacdots, 0, sizeof(level_pacdots));
+		memset(level_power_pellets, 0, sizeof(level_power_pellets));
+		pacdot_row_count[y] = pack_decode_maze_row(&reader, field_width,
+				walls[y], level_pacdots, level_power_pellets);
+		if(start_of_level) {
+			memcpy(state.pacdots[y], level_pacdots, FIELD_ROW_WORDS);
+			memcpy(state.power_pellets[y], level_power_pellets, FIELD_ROW_WORDS);
+		} else {
+			// Cells whose contents differ from the maze (re-using
+			// level_pacdots for them)
+			uint8_t* changed = level_pacdots;
+			uint8_t erased = 0;
+			for(uint8_t w = 0; w < field_row_words; w++) {
+				changed[w] = (level_pacdots[w] ^ state.pacdots[y][w])
+						| (level_power_pellets[w] ^ state.power_pellets[y][w]);
+			}
+			for(uint8_t x = 0; x < field_width; x++) {
+				if(bitboard_test(changed, x)) {
+					erase_pixel_at(x, y);
+					erased = 1;
+				}
+			}
+			if(erased) {
+				// Back to the start of the next row
+				move_cursor(1, y+2);
+			}
+			pacdot_row_count[y] = bitboard_popcount(state.pacdots[y], field_row_words);
+		}
+		num_pacdots += pacdot_row_count[y];
+	}
+	set_display_attribute(BG_CYAN);
+}
+
+// Award points for eating a ghost - the first ghost eaten after a power
+// pellet is worth 200 points, and each one after that is worth double the
+// one before, up to 1600 points.
+static void determine_ghost_score(uint8_t number) {
+	if(number > 4) {
+		number = 4;
+	}
+	add_to_score(200 << (number - 1));
+	display_score();
+}
+
+// The given ghost has just been eaten by the pac-man (which is at the
+// ghost's location). The ghost turns into a pair of eyes which will make
+// their way back to the ghost home. The pac-man is drawn on top.
+static void eat_ghost(uint8_t ghostnum) {
+	state.ghost_state[ghostnum] = GHOST_STATE_EYES;
+	remove_ghost_occupied(state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+	state.ghost_kills++;
+	determine_ghost_score(state.ghost_kills);
+	draw_pacman_at(state.pacman_x, state.pacman_y);
+}
+
+// Move a pair of eyes one step closer to the ghost home. The direction is
+// looked up in the level's home_flow table. When the eyes arrive, the ghost
+// comes back to life (in its normal colours) in the ghost home.
+static void move_eyes(uint8_t ghostnum) {
+	uint8_t x = state.ghost_x[ghostnum];
+	uint8_t y = state.ghost_y[ghostnum];
+	uint8_t flow = pack_code_at(level.home_flow
+			+ pgm_read_word(&level.home_flow_rows[y]), x);
+	if(flow == FLOW_NO_ROUTE) {
+		// Shouldn't happen - eyes are only ever on cells a ghost can reach
+		return;
+	}
+	if(flow == FLOW_AT_HOME) {
+		// Home - bring the ghost back to life
+		state.ghost_state[ghostnum] = GHOST_STATE_ACTIVE;
+		add_ghost_occupied(x, y);
+		draw_ghost_at(ghostnum, x, y);
+		return;
+	}
+	// Move the eyes, restoring whatever they were drawn over
+	state.ghost_direction[ghostnum] = flow;
+	switch(flow) {
+		case DIRN_LEFT:
+			state.ghost_x[ghostnum]--;
+			break;
+		case DIRN_RIGHT:
+			state.ghost_x[ghostnum]++;
+			break;
+		case DIRN_UP:
+			state.ghost_y[ghostnum]--;
+			break;
+		case DIRN_DOWN:
+			state.ghost_y[ghostnum]++;
+			break;
+	}
+	redraw_cell_at(x, y);
+	if(!is_pacman_at(state.ghost_x[ghostnum], state.ghost_y[ghostnum])) {
+		draw_eyes_at(state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+	}
+}
+
+// Put the given ghost back in the ghost home (and draw it). Ghosts start
+// every second cell from the left of the ghost home, then fill in the
+// cells in between - if there are more ghosts than cells they share.
+static void place_ghost_at_home(uint8_t ghostnum) {
+	uint8_t home_width = level.ghost_home_x_right - level.ghost_home_x_left + 1;
+	state.ghost_x[ghostnum] = level.ghost_home_x_left + (2*ghostnum) % home_width;
+	state.ghost_y[ghostnum] = level.ghost_home_y;
+	state.ghost_direction[ghostnum] = INIT_GHOST_DIRN;
+	state.ghost_state[ghostnum] = GHOST_STATE_ACTIVE;
+	draw_ghost_at(ghostnum, state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+}
+
+// Copy the details of the level given by the state from the levels table
+static void load_level(void) {
+	memcpy_P(&level, &levels[state.level_number], sizeof(level));
+	field_width = level.width;
+	field_height = level.height;
+	field_row_words = BITBOARD_ROW_WORDS(field_width);
+	pacman_move_ticks = PERIOD_TICKS(level.pacman_move_period);
+}
+
+// Set each ghost's behaviour and speed from its definition
+static void initialise_ghost_details(void) {
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		ghost_behaviour[i] = pgm_read_byte(&ghost_definitions[i].behaviour);
+		// Ghost speeds are scaled for the level
+		ghost_move_ticks[i] = PERIOD_TICKS((uint32_t)pgm_read_word(
+				&ghost_definitions[i].move_period) * level.ghost_period_percent / 100);
+	}
+}
+
+// Work out everything that depends on the state again after it has been
+// replaced (see game_restore()) and show the pac-man, ghosts, score and
+// lives. The pac-dots must already be up to date on the display.
+static void state_restored(void) {
+	set_score(state.score);
+	prng_set_state(state.random_state);
+	initialise_ghost_details();
+	initialise_ghost_occupied();
+	distance_field_valid = 0;
+	draw_pacman_and_ghosts();
+	display_lives();
+	display_score();
+	display_no_dots();
+}
+
+/////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////
+// Public Functions
+void initialise_game_level(void) {
+	load_level();
+	initialise_game_field(1);
+	state.pacman_x = level.pacman_x;
+	state.pacman_y = level.pacman_y;
+	state.pacman_direction = level.pacman_direction;
+	distance_field_valid = 0;
+	draw_pacman_at(state.pacman_x, state.pacman_y);
+	// The level says how many ghosts there are - as many as there is
+	// room for
+	state.num_ghosts = level.num_ghosts;
+	if(state.num_ghosts > MAX_GHOSTS) {
+		state.num_ghosts = MAX_GHOSTS;
+	}
+	initialise_ghost_details();
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		place_ghost_at_home(i);
+	}
+	initialise_ghost_occupied();
+	state.pacman_last_move = state.game_ticks;
+	reset_ghost_move_times(state.game_ticks);
+}
+
+void initialise_game(void) {
+	// Start from nothing - level 0, tick 0, no power pellet eaten, ...
+	memset(&state, 0, sizeof(state));
+	state.lives = MAX_LIVES;
+	initialise_game_level();
+	// Initialise Life Display
+	display_lives();
+	state.game_running = 1;
+}
+
+void game_step(int8_t held_direction, int8_t pushed_direction) {
+	if(!state.game_running) {
+		// Game is over - do nothing
+		return;
+	}
+	state.game_ticks++;
+	if(state.power_active && get_game_time() - state.powered_period >= POWER_PERIOD_MS) {
+		end_power_mode();
+	}
+	// The joystick takes priority over the buttons and cursor keys
+	if(held_direction >= 0) {
+		change_pacman_direction(held_direction);
+	} else if(pushed_direction >= 0) {
+		change_pacman_direction(pushed_direction);
+	}
+	// (Ticks since the last move are worked out in 8 bits, the same as the
+	// tick it is kept as)
+	if((uint8_t)(state.game_ticks - state.pacman_last_move) >= pacman_move_ticks) {
+		move_pacman();
+		state.pacman_last_move = state.game_ticks;
+	}
+	// Move any ghosts that are due to move (each ghost has its own speed)
+	move_ghosts(state.game_ticks);
+}
+
+uint32_t get_game_ticks(void) {
+	return state.game_ticks;
+}
+
+uint32_t get_game_time(void) {
+	return state.game_ticks * GAME_TICK_MS;
+}
+
+uint32_t get_power_time_remaining(void) {
+	if(!state.power_active) {
+		return 0;
+	}
+	return POWER_PERIOD_MS - (get_game_time() - state.powered_period);
+}
+
+GameState* get_game_state(void) {
+	// The score and random number generator keep their own state - bring
+	// our copies up to date
+	state.score = get_score();
+	state.random_state = prng_get_state();
+	return &state;
+}
+
+void game_state_changed(void) {
+	load_level();
+	initialise_game_field(0);
+	state_restored();
+}
+
+void game_snapshot(void* buffer) {
+	memcpy(buffer, get_game_state(), sizeof(state));
+}
+
+GameState* game_change_begin(void) {
+	// Take the pac-man and ghosts off the display - game_change_end() draws
+	// them again wherever they end up
+	erase_pixel_at(state.pacman_x, state.pacman_y);
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		erase_pixel_at(state.ghost_x[i], state.ghost_y[i]);
+	}
+	return get_game_state();
+}
+
+void game_cell_changed(uint8_t x, uint8_t y) {
+	erase_pixel_at(x, y);
+	count_pacdots_in_row(y);
+}
+
+void game_change_end(void) {
+	state_restored();
+}
+
+void game_restore(const void* buffer) {
+	const GameState* snapshot = buffer;
+	if(snapshot->level_number != state.level_number) {
+		// Different maze - draw everything again
+		memcpy(&state, snapshot, sizeof(state));
+		game_state_changed();
+		return;
+	}
+	// Same maze - only the cells that have changed are drawn again
+	game_change_begin();
+	for(uint8_t y = 0; y < field_height; y++) {
+		uint8_t changed[FIELD_ROW_WORDS];
+		for(uint8_t w = 0; w < field_row_words; w++) {
+			changed[w] = (state.pacdots[y][w] ^ snapshot->pacdots[y][w])
+					| (state.power_pellets[y][w] ^ snapshot->power_pellets[y][w]);
+		}
+		memcpy(state.pacdots[y], snapshot->pacdots[y], FIELD_ROW_WORDS);
+		memcpy(state.power_pellets[y], snapshot->power_pellets[y], FIELD_ROW_WORDS);
+		for(uint8_t x = 0; x < field_width; x++) {
+			if(bitboard_test(changed, x)) {
+				game_cell_changed(x, y);
+			}
+		}
+	}
+	memcpy(&state, snapshot, sizeof(state));
+	game_change_end();
+}
+
+// Returns the row of pac-dots (or power pellets) for a cell that starts the
+// level with the given code (MAZE_CODE_PACDOT or MAZE_CODE_POWER_PELLET)
+static uint8_t* dot_row(uint8_t code, uint8_t y) {
+	if(code == MAZE_CODE_PACDOT) {
+		return state.pacdots[y];
+	}
+	return state.power_pellets[y];
+}
+
+uint8_t game_pack_dots(uint8_t* buffer) {
+	RleWriter writer;
+	PackReader reader;
+	uint8_t bits = 0;
+	uint8_t num_bits = 0;
+	rle_writer_start(&writer, buffer, GAME_PACKED_DOTS_SIZE);
+	pack_reader_start(&reader, level.maze);
+	for(uint8_t y = 0; y < field_height; y++) {
+		for(uint8_t x = 0; x < field_width; x++) {
+			uint8_t code = pack_reader_next(&reader);
+			if(code == MAZE_CODE_PACDOT || code == MAZE_CODE_POWER_PELLET) {
+				bits = (bits << 1) | (bitboard_test(dot_row(code, y), x) != 0);
+				if(++num_bits == 8) {
+					rle_writer_add(&writer, bits);
+					num_bits = 0;
+				}
+			}
+		}
+	}
+	if(num_bits) {
+		rle_writer_add(&writer, bits << (8 - num_bits));
+	}
+	return writer.length;
+}
+
+uint8_t game_unpack_dots(uint8_t level_number, const uint8_t* packed, uint8_t length) {
+	LevelData packed_level;
+	if(level_number >= NUM_LEVELS) {
+		return 0;
+	}
+	memcpy_P(&packed_level, &levels[level_number], sizeof(packed_level));
+	// The first pass checks that there are the right number of bits for the
+	// level, the second puts them in the state
+	for(uint8_t pass = 0; pass < 2; pass++) {
+		RleReader rle;
+		PackReader reader;
+		int16_t bits = 0;
+		uint8_t num_bits = 0;
+		rle_reader_start(&rle, packed, length);
+		pack_reader_start(&reader, packed_level.maze);
+		if(pass) {
+			memset(state.pacdots, 0, sizeof(state.pacdots));
+			memset(state.power_pellets, 0, sizeof(state.power_pellets));
+		}
+		for(uint8_t y = 0; y < packed_level.height; y++) {
+			for(uint8_t x = 0; x < packed_level.width; x++) {
+				uint8_t code = pack_reader_next(&reader);
+				if(code != MAZE_CODE_PACDOT && code != MAZE_CODE_POWER_PELLET) {
+					continue;
+				}
+				if(num_bits == 0) {
+					bits = rle_reader_next(&rle);
+					if(bits < 0) {
+						return 0;
+					}
+					num_bits = 8;
+				}
+				num_bits--;
+				if(pass && ((bits >> num_bits) & 1)) {
+					bitboard_set(dot_row(code, y), x);
+				}
+			}
+		}
+		if(rle_reader_next(&rle) >= 0) {
+			// Left over bytes
+			return 0;
+		}
+	}
+	return 1;
+}
+
+uint32_t game_changed_rows(void) {
+	return changed_rows;
+}
+
+void game_clear_changed_rows(void) {
+	changed_rows = 0;
+}
+
+uint16_t get_game_checksum(void) {
+	uint16_t crc = CRC16_INITIAL_VALUE;
+	crc = crc16_block(crc, &state.game_ticks, sizeof(state.game_ticks));
+	crc = crc16_update(crc, state.level_number);
+	crc = crc16_update(crc, state.pacman_x);
+	crc = crc16_update(crc, state.pacman_y);
+	crc = crc16_update(crc, state.pacman_direction);
+	crc = crc16_update(crc, state.lives);
+	crc = crc16_update(crc, state.power_active);
+	uint32_t current_score = get_score();
+	crc = crc16_block(crc, &current_score, sizeof(current_score));
+	crc = crc16_block(crc, state.ghost_x, state.num_ghosts);
+	crc = crc16_block(crc, state.ghost_y, state.num_ghosts);
+	crc = crc16_block(crc, state.ghost_direction, state.num_ghosts);
+	crc = crc16_block(crc, state.ghost_state, state.num_ghosts);
+	for(uint8_t y = 0; y < field_height; y++) {
+		crc = crc16_block(crc, state.pacdots[y], field_row_words);
+		crc = crc16_block(crc, state.power_pellets[y], field_row_words);
+	}
+	return crc;
+}
+
+void start_next_level(void) {
+	// After the last level we go back to the first
+	state.level_number = (state.level_number + 1) % NUM_LEVELS;
+	initialise_game_level();
+}
+
+uint16_t get_pacman_move_period(void) {
+	return level.pacman_move_period;
+}
+
+int8_t move_pacman(void) {
+	if(!state.game_running) {
+		// Game is over - do nothing
+		return 0;
+	}
+	// If the pac-man is about to exit through the end of a passage-way
+	// then wrap its location around to the other side of the game field
+	// YOUR CODE HERE - you may need to alter the code below also
+	
+	// Work out what is in the direction we want to move
+	int8_t cell_contents = what_is_in_dirn(state.pacman_x, state.pacman_y, state.pacman_direction);
+	if(cell_contents == CELL_IS_WALL) {
+		return 0;	// We can't move - wall is straight ahead
+	}
+	// We can move - erase the pac-man in the current location
+	erase_pixel_at(state.pacman_x, state.pacman_y);
+	// Update the pac-man location
+	if(state.pacman_direction == DIRN_LEFT) {
+		state.pacman_x--;
+		if(state.pacman_x == 0) {
+			state.pacman_x = field_width - 1;
+		}
+	} else if(state.pacman_direction == DIRN_RIGHT) {
+		state.pacman_x++;
+		if(state.pacman_x == field_width - 1) {
+			state.pacman_x = 0;
+		}
+	} else if(state.pacman_direction == DIRN_UP) {
+		state.pacman_y--;
+	} else {
+		state.pacman_y++;
+	}
+	// Distances to the pac-man will need to be worked out again
+	distance_field_valid = 0;
+	if(cell_contents >= 0) {
+		// We've encountered a ghost - draw both at the location
+		// Set the background colour to that of the ghost
+		// before we print out the pac-man
+		// Note that the variable cell_contents contains the ghost number
+		// Lose a life
+		if (state.ghost_state[cell_contents] == GHOST_STATE_FRIGHTENED) {
+			eat_ghost(cell_contents);
+		} else {
+			state.lives--;
+			// Update Life Display
+			display_lives();
+			// Check if pacman still has lives
+			if(state.lives > 0) {
+				reset_entities_pos();
+				} else {
+				set_display_attribute(ghost_colour(cell_contents));
+				draw_pacman_at(state.pacman_x, state.pacman_y);
+				state.game_running = 0;
+			}
+		}
+	} else {
+		if(cell_contents == CELL_CONTAINS_PACDOT) {
+			eat_pacdot();
+		} else if (cell_contents == CELL_CONTAINS_POWER_PELLET) {
+			eat_power_pellet();
+		}
+	}
+	draw_pacman_at(state.pacman_x, state.pacman_y);
+	return 1;
+}
+
+void reset_entities_pos(void) {
+	// Reset Pacman
+	erase_pixel_at(state.pacman_x, state.pacman_y);
+	state.pacman_x = level.pacman_x;
+	state.pacman_y = level.pacman_y;
+	draw_pacman_at(state.pacman_x, state.pacman_y);
+	distance_field_valid = 0;
+	// Reset Ghosts
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		if(!is_pacman_at(state.ghost_x[i], state.ghost_y[i])) {
+			erase_pixel_at(state.ghost_x[i], state.ghost_y[i]);
+		}
+	}
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		place_ghost_at_home(i);
+	}
+	initialise_ghost_occupied();
+}
+
+void move_ghosts(uint32_t tick) {
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		// (The subtraction must be done in 8 bits so it still works once
+		// the tick has wrapped around)
+		uint8_t ticks_since_move = (uint8_t)tick - state.ghost_last_move[i];
+		if(ticks_since_move >= ghost_move_ticks[i]) {
+			move_ghost(i);
+			state.ghost_last_move[i] = tick;
+		}
+	}
+}
+
+void reset_ghost_move_times(uint32_t tick) {
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		state.ghost_last_move[i] = tick;
+	}
+}
+
+int8_t change_pacman_direction(int8_t direction) {
+	if(!state.game_running) {
+		// Game is over - do nothing
+		return 0;
+	}
+	// Work out what is in the direction we want to move
+	int8_t cell_contents = what_is_in_dirn(state.pacman_x, state.pacman_y, direction);
+	if(cell_contents == CELL_IS_WALL) {
+		// Can't move
+		return 0;
+	} else {
+		state.pacman_direction = direction;
+		// Redraw the pacman so it is facing in the right direction
+		draw_pacman_at(state.pacman_x, state.pacman_y);
+		return 1;
+	}
+}
+
+void move_ghost(int8_t ghostnum) {
+	if(!state.game_running) {
+		// Game is over - do nothing
+		return;
+	}
+	if(state.ghost_state[ghostnum] == GHOST_STATE_EYES) {
+		// Ghost has been eaten - head for home
+		move_eyes(ghostnum);
+		return;
+	}
+	int8_t dirn_to_move = determine_ghost_direction_to_move(ghostnum);
+	if(dirn_to_move < 0) {
+		// Ghost can't move (e.g. boxed in) - do nothing
+		return;
+	}
+	
+	// Erase the ghost from the current location
+	uint8_t old_x = state.ghost_x[ghostnum];
+	uint8_t old_y = state.ghost_y[ghostnum];
+	erase_pixel_at(old_x, old_y);
+	
+	// Update the ghost's direction (it's possible this may be the same value)
+	state.ghost_direction[ghostnum] = dirn_to_move;
+	// Update the ghost's location
+	switch(dirn_to_move) {
+		case DIRN_LEFT:
+			state.ghost_x[ghostnum]--;
+			break;
+		case DIRN_RIGHT:
+			state.ghost_x[ghostnum]++;
+			break;
+		case DIRN_UP:
+			state.ghost_y[ghostnum]--;
+			break;
+		case DIRN_DOWN:
+			state.ghost_y[ghostnum]++;
+			break;
+	}
+	
+	remove_ghost_occupied(old_x, old_y);
+	add_ghost_occupied(state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+	// Another ghost may share the cell we left (e.g. in the ghost home)
+	int8_t other_ghost = ghost_at(old_x, old_y);
+	if(other_ghost >= 0) {
+		draw_ghost_at(other_ghost, old_x, old_y);
+	}
+	// Check if the pac-man is at this ghost location. 
+	if(is_pacman_at(state.ghost_x[ghostnum], state.ghost_y[ghostnum])) {
+		if (state.ghost_state[ghostnum] == GHOST_STATE_FRIGHTENED) {
+			eat_ghost(ghostnum);
+		} else {
+			// Update Lives
+			state.lives--;
+			// Update Life Display
+			display_lives();
+			// Check if pacman still has lives
+			if(state.lives > 0) {
+				reset_entities_pos();
+			} else {
+			state.game_running = 0;
+			set_display_attribute(ghost_colour(ghostnum));
+			draw_pacman_at(state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+			}
+		}
+	} else {
+		draw_ghost_at(ghostnum, state.ghost_x[ghostnum], state.ghost_y[ghostnum]);
+	}
+	normal_display_mode();
+}
+
+void end_power_mode(void) {
+	state.power_active = 0;
+	state.ghost_kills = 0;
+	for(uint8_t i = 0; i < state.num_ghosts; i++) {
+		if(state.ghost_state[i] == GHOST_STATE_FRIGHTENED) {
+			state.ghost_state[i] = GHOST_STATE_ACTIVE;
+		}
+	}
+}
+
+int8_t is_game_over(void) {
+	return !state.game_running;
+}
+
+int8_t is_level_complete(void) {
+	return (num_pacdots == 0);
+}
+
+
+
@@ -1,122 +1,270 @@
-/*
-** game.h
-**
-** Written by Peter Sutton
-**
-** Function prototypes for those functions available externally.
-*/
-
-#ifndef GAME_H_
-#define GAME_H_
-
-#include <inttypes.h>
-#include <stdio.h>
-#include "ledmatrix.h"
-#include "terminalio.h"
-#include "pixel_colour.h"
-#include <avr/pgmspace.h>
-#include <stdlib.h>
-
-
-// The game field is 31 rows in size by 31 columns.
-// The row number (y) ranges from 0 (top) to 30 (bottom)
-// The column number (x) ranges from 0 (left) to 30 (right)
-#define FIELD_HEIGHT 31
-#define FIELD_WIDTH 31
-
-// Number of ghosts in the game
-#define NUM_GHOSTS 4
-
-#define NUM_DIRECTION_VALUES 4
-// Arguments that can be passed to change_pacman_direction() below
-#define DIRN_LEFT 0
-#define DIRN_UP 1
-#define DIRN_RIGHT 2
-#define DIRN_DOWN 3
-
-// Maximum Pacman Lives
-#define MAX_LIVES (3)
-
-#define CELL_IS_GHOST_HOME (-1)
-#define CELL_IS_WALL (-2)
-#define CELL_CONTAINS_PACMAN (-3)
-#define CELL_CONTAINS_PACDOT (-4)
-#define CELL_EMPTY (-5)
-#define CELL_CONTAINS_POWER_PELLET (-6)
-
-uint8_t lives;
-uint32_t powered_period;
-extern uint8_t power_active;
-extern uint8_t ghost_kills;
-
-// Location of pacman (values will be in the range 0 to FIELD_WIDTH - 1 or FIELD_HEIGHT - 1)
-static uint8_t pacman_x;
-static uint8_t pacman_y;
-
-// Direction of pacman movement (one of the direction values in game.h)
-uint8_t pacman_direction;
-
-// Locations and directions of the ghosts
-static uint8_t ghost_x[NUM_GHOSTS];
-static uint8_t ghost_y[NUM_GHOSTS];
-static uint8_t ghost_direction[NUM_GHOSTS];
-
-// This array will be initially set from the data in init_game_field above and
-// will be updated as pacdots are eaten.
-static uint32_t pacdots[FIELD_HEIGHT];
-static uint32_t power_pellets[FIELD_HEIGHT];
-
-// Original Terminal Colours to be used
-extern uint8_t ghost_original_colours[NUM_GHOSTS];
-
-// Terminal colours to be used
-extern uint8_t ghost_colours[NUM_GHOSTS];
-
-// Disabled ghosts
-extern uint8_t disabled_ghosts[NUM_GHOSTS];
-
-// Arguments that can be passed to 
-
-// Initialise the game and output the initial display.
-void initialise_game(void); 
-
-// Initialise the game level - re-outputs the game field
-// and restores all positions to their original values. This 
-// function is called by initialise_game() above and only 
-// needs to be called again if a new level is started.
-void initialise_game_level(void);
-
-// Attempt to move the pacman in its current direction. Returns 1 if successful, 
-// 0 otherwise (e.g. there is a wall in the way, or the pacman would move into
-// a ghost). Nothing happens if the game is over. (0 is returned.)
-int8_t move_pacman(void);
-
-// Attempt to change the direction of the pacman. Returns 1 if successful (i.e. 
-// next call to move_pacman() would succeed, 0 otherwise (e.g. there is a wall
-// in the way.)
-// The "direction" argument takes on one of the values above.
-// Nothing happens if the game is over (0 is returned.)
-int8_t change_pacman_direction(int8_t direction);
-
-// Attempt to move a ghost (ghostnum is 0 to NUM_GHOSTS - 1).
-// The direction is chosen based on the location of the ghost
-// and the location of the pacman and which ghost this is.
-// (Different ghosts have different behaviours.)
-// Nothing happens if the game is over.
-void move_ghost(int8_t ghostnum);
-
-// Returns 1 if the game is over, 0 otherwise
-// Must only be called after initialise_game().
-int8_t is_game_over(void);
-
-// Returns 1 if the level is complete (all pac-dots eaten), 0 otherwise
-// Must only be called after initialise_game().
-int8_t is_level_complete(void);
-
-void display_score(void);
-
-void reset_entities_pos(void);
-
-int8_t what_is_in_dirn(uint8_t x, uint8_t y, uint8_t direction);
-
-#endif
+/*
+** game.h
+**
+** Written by Peter Sutton
+**
+** Function prototypes for those functions available externally.
+*/
+
+#ifndef GAME_H_
+#define GAME_H_
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "ledmatrix.h"
+#include "terminalio.h"
+#include "pixel_colour.h"
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include "bitboard.h"
+
+
+// The game field is field_height rows in size by field_width columns - the
+// size depends on the level being played (the original maze is 31 by 31).
+// The row number (y) ranges from 0 (top) to field_height - 1 (bottom)
+// The column number (x) ranges from 0 (left) to field_width - 1 (right)
+extern uint8_t field_width;
+extern uint8_t field_height;
+
+// Largest game field that space is reserved for. May be raised if there is
+// enough RAM, as far as:
+//	- a height of 32 (game_changed_rows() has a bit for each row)
+//	- a width and height of 32 (the map of the field must fit on the LED
+//	  matrix - see maze_view.h)
+//	- a height times width (rounded up to a multiple of 8) below 0x8000 (the
+//	  bit index of a cell in a rewind record - see rewind.c)
+// Each of these is checked when the module concerned is compiled.
+#ifndef MAX_FIELD_WIDTH
+#define MAX_FIELD_WIDTH 31
+#endif
+#ifndef MAX_FIELD_HEIGHT
+#define MAX_FIELD_HEIGHT 31
+#endif
+
+// Number of bytes used to store one row of the field as bits (see bitboard.h)
+#define FIELD_ROW_WORDS BITBOARD_ROW_WORDS(MAX_FIELD_WIDTH)
+
+// Number of ghosts in a level that doesn't give its own number (see
+// tools/mazec.c)
+#define NUM_GHOSTS 4
+
+// Maximum number of ghosts that can be in play (space is reserved for this
+// many). May be set anywhere from NUM_GHOSTS up to 16 if there is enough RAM.
+#ifndef MAX_GHOSTS
+#define MAX_GHOSTS 8
+#endif
+#if MAX_GHOSTS < NUM_GHOSTS || MAX_GHOSTS > 16
+#error "MAX_GHOSTS must be between NUM_GHOSTS and 16"
+#endif
+
+#define NUM_DIRECTION_VALUES 4
+// Arguments that can be passed to change_pacman_direction() below
+#define DIRN_LEFT 0
+#define DIRN_UP 1
+#define DIRN_RIGHT 2
+#define DIRN_DOWN 3
+
+// Maximum Pacman Lives
+#define MAX_LIVES (3)
+
+// The lives left are shown on LEDs on these pins of port C - they must be
+// claimed (see ports.h) before the game is started
+#define LIVES_LED_PINS 0x07
+
+// How long (in milliseconds) the ghosts stay frightened after the
+// pac-man eats a power pellet
+#define POWER_PERIOD_MS (15000UL)
+
+#define CELL_IS_GHOST_HOME (-1)
+#define CELL_IS_WALL (-2)
+#define CELL_CONTAINS_PACMAN (-3)
+#define CELL_CONTAINS_PACDOT (-4)
+#define CELL_EMPTY (-5)
+#define CELL_CONTAINS_POWER_PELLET (-6)
+
+// State of each ghost - eaten ghosts travel back to the ghost home
+// as a pair of eyes (following the level's home_flow table) and are then
+// brought back to life
+// Frightened ghosts (after the pac-man eats a power pellet) run away from
+// the pac-man and can be eaten.
+#define GHOST_STATE_ACTIVE 0
+#define GHOST_STATE_EYES 1
+#define GHOST_STATE_FRIGHTENED 2
+
+// State of the game - everything that changes as it is played. game.c
+// owns the only copy (everything else it keeps is worked out from this and
+// the level) so a whole game can be saved, restored or compared as one
+// block - see game_snapshot() and game_restore() below. Positions are in
+// the range 0 to field_width - 1 (x) or field_height - 1 (y) and directions
+// are the DIRN_ values above. Bitboard rows are as described in bitboard.h
+// (bit x of row y is set if there is a pac-dot or power pellet at (x,y)).
+typedef struct {
+	uint8_t level_number;
+	uint8_t game_running;		// 1 while the game is running, 0 once over
+	uint32_t game_ticks;		// ticks played (see game_step())
+	uint32_t score;				// copy of the score (see score.h)
+	uint16_t random_state;		// copy of the generator's state (see prng.h)
+	uint8_t lives;
+	uint8_t power_active;		// 1 while the ghosts are frightened
+	uint8_t ghost_kills;		// ghosts eaten since the last power pellet
+	uint32_t powered_period;	// game time the last power pellet was eaten
+	uint8_t pacman_x;
+	uint8_t pacman_y;
+	uint8_t pacman_direction;
+	uint8_t pacman_last_move;	// tick (low 8 bits) the pac-man last moved
+	uint8_t num_ghosts;
+	uint8_t ghost_x[MAX_GHOSTS];
+	uint8_t ghost_y[MAX_GHOSTS];
+	uint8_t ghost_direction[MAX_GHOSTS];
+	uint8_t ghost_state[MAX_GHOSTS];
+	uint8_t ghost_last_move[MAX_GHOSTS];	// tick (low 8 bits) of last move
+	uint8_t pacdots[MAX_FIELD_HEIGHT][FIELD_ROW_WORDS];
+	uint8_t power_pellets[MAX_FIELD_HEIGHT][FIELD_ROW_WORDS];
+} GameState;
+
+// Arguments that can be passed to 
+
+// Initialise the game and output the initial display.
+void initialise_game(void); 
+
+// Initialise the game level - re-outputs the game field
+// and restores all positions to their original values. This 
+// function is called by initialise_game() above and only 
+// needs to be called again if a new level is started.
+void initialise_game_level(void);
+
+// Move on to the next level (back to the first after the last one) and
+// initialise it as above.
+void start_next_level(void);
+
+// Returns the time (in milliseconds) between moves of the pac-man on the
+// current level
+uint16_t get_pacman_move_period(void);
+
+// Length of a game tick in milliseconds. The game moves on a tick at a time
+// (see game_step()) rather than by reading the clock, so the same input at
+// the same ticks always plays the same way.
+#define GAME_TICK_MS 10
+
+// Move the game on by one tick. held_direction is the direction the
+// joystick is being held in (-1 if it is at rest) and pushed_direction the
+// direction of a button or cursor key pushed since the last tick (-1 if
+// none) - this is ignored if the joystick is being held. The pac-man and
+// any ghosts that are due to move are moved, and the frightened period is
+// ended if it is over. Nothing happens if the game is over.
+void game_step(int8_t held_direction, int8_t pushed_direction);
+
+// Returns the number of ticks played since the game started, or the
+// same time in milliseconds
+uint32_t get_game_ticks(void);
+uint32_t get_game_time(void);
+
+// Returns the time (in milliseconds) left before the ghosts stop being
+// frightened, or 0 if they aren't
+uint32_t get_power_time_remaining(void);
+
+// Copy the state of the game to buffer (sizeof(GameState) bytes)
+void game_snapshot(void* buffer);
+
+// Go back to a state copied by game_snapshot(). Only the parts of the
+// display that differ are drawn again (all of it if the level differs).
+void game_restore(const void* buffer);
+
+// Returns the game's own state (brought up to date) - e.g. to write it
+// straight to EEPROM without needing a copy. If it is changed (e.g. a saved
+// game read straight into it) game_state_changed() must be called after.
+GameState* get_game_state(void);
+
+// Bring everything else up to date with a changed state (see above) and
+// redraw the whole display
+void game_state_changed(void);
+
+// Change the state in place, redrawing only what changes (as for
+// game_restore()) - e.g. to step back through the rewind buffer (see
+// rewind.h). game_change_begin() takes the pac-man and ghosts off the
+// display and returns the state to be changed. Each cell whose pac-dot or
+// power pellet is changed must then be passed to game_cell_changed(), and
+// game_change_end() called once the state is complete. The level must not
+// be changed.
+GameState* game_change_begin(void);
+void game_cell_changed(uint8_t x, uint8_t y);
+void game_change_end(void);
+
+// Packing the pac-dots and power pellets - e.g. to save the game in the
+// EEPROM (see saved_game.h). There is a bit for each cell that has a pac-dot
+// or power pellet at the start of the level (along each row in turn, from
+// the top), set if it is still there, and the bits are run length encoded
+// (see rle.h) - so few bytes are needed early or late in a level.
+// GAME_PACKED_DOTS_SIZE bytes is enough for any level.
+#define GAME_PACKED_DOTS_SIZE 40
+// Pack the pac-dots and power pellets into buffer. Returns the number of
+// bytes used.
+uint8_t game_pack_dots(uint8_t* buffer);
+// Unpack the pac-dots and power pellets of the given level (packed by
+// game_pack_dots()) into the state (see get_game_state() above). Returns 1
+// if successful, 0 if they don't fit the level (the state isn't changed).
+uint8_t game_unpack_dots(uint8_t level_number, const uint8_t* packed, uint8_t length);
+
+// Returns the rows (bit y for row y) whose pac-dots or power pellets have
+// changed since game_clear_changed_rows() was last called - e.g. so a save
+// only needs the rows that have changed since the last full save (see
+// saved_game.h). Every row is marked as changed when the maze is set up
+// (a new level, or a state that has been replaced).
+uint32_t game_changed_rows(void);
+void game_clear_changed_rows(void);
+
+// Returns a checksum of the state of the game (time, positions, lives,
+// score, pac-dots, ...) - used to check that a replayed game (see
+// journal.h) ended up exactly the same as when it was played
+uint16_t get_game_checksum(void);
+
+// Attempt to move the pacman in its current direction. Returns 1 if successful, 
+// 0 otherwise (e.g. there is a wall in the way, or the pacman would move into
+// a ghost). Nothing happens if the game is over. (0 is returned.)
+int8_t move_pacman(void);
+
+// Attempt to change the direction of the pacman. Returns 1 if successful (i.e. 
+// next call to move_pacman() would succeed, 0 otherwise (e.g. there is a wall
+// in the way.)
+// The "direction" argument takes on one of the values above.
+// Nothing happens if the game is over (0 is returned.)
+int8_t change_pacman_direction(int8_t direction);
+
+// Attempt to move a ghost (ghostnum is 0 to the number of ghosts - 1).
+// The direction is chosen based on the location of the ghost
+// and the location of the pacman and which ghost this is.
+// (Different ghosts have different behaviours.)
+// Nothing happens if the game is over.
+void move_ghost(int8_t ghostnum);
+
+// Move each ghost that is due to move at the given tick (see
+// get_game_ticks()). Each ghost moves at its own speed.
+void move_ghosts(uint32_t tick);
+
+// Restart the timing of ghost movements from the given tick - e.g. when a
+// level starts.
+void reset_ghost_move_times(uint32_t tick);
+
+// Returns 1 if the game is over, 0 otherwise
+// Must only be called after initialise_game().
+int8_t is_game_over(void);
+
+// Returns 1 if the level is complete (all pac-dots eaten), 0 otherwise
+// Must only be called after initialise_game().
+int8_t is_level_complete(void);
+
+// Ends the frightened period started by eating a power pellet - any
+// ghosts that are still frightened go back to normal.
+void end_power_mode(void);
+
+void display_score(void);
+
+void reset_entities_pos(void);
+
+// Returns what is in the cell at (x,y) - one of the CELL_ values above or
+// the number of a ghost that is there (eyes of eaten ghosts are ignored)
+int8_t what_is_at(uint8_t x, uint8_t y);
+
+int8_t what_is_in_dirn(uint8_t x, uint8_t y, uint8_t direction);
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * highscores.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "highscores.h"
+#include "eeprom_queue.h"
+#include "crc16.h"
+
+#if HIGHSCORE_RECORDS <= NUM_HIGHSCORES
+#error "HIGHSCORE_RECORDS must be more than NUM_HIGHSCORES"
+#endif
+
+typedef struct {
+	uint32_t score;
+	uint16_t sequence;	// one more than the record written before
+	uint16_t crc;		// CRC (see crc16.h) of the rest of the record
+} HighscoreRecord;
+
+static HighscoreRecord EEMEM records[HIGHSCORE_RECORDS];
+
+// The table (best first) and the record each entry is kept in
+static uint32_t table[NUM_HIGHSCORES];
+static uint8_t table_record[NUM_HIGHSCORES];
+static uint8_t num_entries;
+
+// The record written most recently, and its sequence number
+static uint8_t newest_record;
+static uint16_t newest_sequence;
+
+// The record being written
+static HighscoreRecord new_record;
+
+static uint16_t record_crc(const HighscoreRecord* record) {
+	return crc16_block(CRC16_INITIAL_VALUE, record, offsetof(HighscoreRecord, crc));
+}
+
+// Returns 1 if the given record holds an entry of the table, 0 otherwise
+static uint8_t record_in_table(uint8_t record) {
+	for(uint8_t i = 0; i < num_entries; i++) {
+		if(table_record[i] == record) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Returns the position (from 0) that a score would take in the table, or
+// NUM_HIGHSCORES if it isn't good enough
+static uint8_t table_position(uint32_t score) {
+	uint8_t i = 0;
+	while(i < num_entries && table[i] >= score) {
+		i++;
+	}
+	return i;
+}
+
+// Put a score (kept in the given record) in the table if it is good enough
+static void insert(uint32_t score, uint8_t record) {
+	uint8_t position = table_position(score);
+	if(position == NUM_HIGHSCORES) {
+		return;
+	}
+	if(num_entries < NUM_HIGHSCORES) {
+		num_entries++;
+	}
+	// Move the worse scores down (the last drops out if the table is full)
+	for(uint8_t i = num_entries - 1; i > position; i--) {
+		table[i] = table[i - 1];
+		table_record[i] = table_record[i - 1];
+	}
+	table[position] = score;
+	table_record[position] = record;
+}
+
+void highscores_init(void) {
+	HighscoreRecord record;
+	num_entries = 0;
+	newest_record = HIGHSCORE_RECORDS - 1;
+	newest_sequence = 0;
+	uint8_t found = 0;
+	for(uint8_t i = 0; i < HIGHSCORE_RECORDS; i++) {
+		eeprom_read_block(&record, &records[i], sizeof(record));
+		if(record.crc != record_crc(&record) || record.score == 0) {
+			continue;
+		}
+		insert(record.score, i);
+		// (Sequence numbers wrap around, so the newer of two is the one
+		// less than half way round ahead of the other)
+		if(!found || (int16_t)(record.sequence - newest_sequence) > 0) {
+			newest_record = i;
+			newest_sequence = record.sequence;
+			found = 1;
+		}
+	}
+}
+
+uint8_t highscores_add(uint32_t score) {
+	uint8_t position = table_position(score);
+	if(score == 0 || position == NUM_HIGHSCORES) {
+		return 0;
+	}
+	// The next record round the ring that isn't in use (there are more
+	// records than entries, so there always is one)
+	uint8_t record = newest_record;
+	do {
+		record = (record + 1) % HIGHSCORE_RECORDS;
+	} while(record_in_table(record));
+	// The last entry added may still be being written from new_record
+	eeprom_queue_wait();
+	new_record.score = score;
+	new_record.sequence = newest_sequence + 1;
+	new_record.crc = record_crc(&new_record);
+	eeprom_queue_write(&records[record], &new_record, sizeof(new_record));
+	newest_record = record;
+	newest_sequence = new_record.sequence;
+	insert(score, record);
+	return position + 1;
+}
+
+uint32_t highscores_get(uint8_t position) {
+	if(position == 0 || position > num_entries) {
+		return 0;
+	}
+	return table[position - 1];
+}
@@ -0,0 +1,37 @@
+/*
+ * highscores.h
+ *
+ * Author: Joel Foster
+ *
+ * Table of the best NUM_HIGHSCORES scores, kept in the EEPROM. Each entry
+ * is a record (with a CRC) in a ring of HIGHSCORE_RECORDS records. A new
+ * entry is written to the next record round the ring that isn't holding
+ * an entry of the table (the entry it pushes out of the table is just left
+ * there), so each new high score writes one record and the writes are
+ * spread over the ring. The table is the best NUM_HIGHSCORES of the records.
+ */
+
+#ifndef HIGHSCORES_H_
+#define HIGHSCORES_H_
+
+#include <stdint.h>
+
+// Number of entries in the table, and number of records they are kept in
+// (this must be more than NUM_HIGHSCORES)
+#define NUM_HIGHSCORES 5
+#define HIGHSCORE_RECORDS 16
+
+// Read the table from the EEPROM - must be called once at start up
+void highscores_init(void);
+
+// Add a score to the table (e.g. at the end of a game) if it is good enough.
+// The new entry is written to the EEPROM in the background (see
+// eeprom_queue.h). Returns the position of the score in the table (1 for
+// the best) or 0 if it isn't in the table.
+uint8_t highscores_add(uint32_t score);
+
+// Returns the score at the given position in the table (1 for the best),
+// or 0 if there isn't one
+uint32_t highscores_get(uint8_t position);
+
+#endif /* HIGHSCORES_H_ */
@@ -0,0 +1,217 @@
+/*
+ * journal.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include "journal.h"
+#include "serialio.h"
+
+// ASCII code for Escape character
+#define ESCAPE_CHAR 27
+
+// Types of record (other than input events, which use the event number)
+#define RECORD_START 'S'
+#define RECORD_END 'E'
+
+// Longest record line that can be received (including the terminating null)
+#define RECORD_LINE_SIZE 24
+
+// Records waiting to be sent. value is the seed for RECORD_START and the
+// checksum for RECORD_END.
+typedef struct {
+	uint8_t type;
+	uint32_t tick;
+	uint16_t value;
+} JournalRecord;
+
+static JournalRecord queue[JOURNAL_QUEUE_SIZE];
+static uint8_t queue_start;
+static uint8_t queue_length;
+
+// Whether a game is being recorded, and the joystick direction (or -1)
+// last recorded for it
+static uint8_t recording;
+static int8_t recorded_held_direction;
+
+// Replay state - the next record (read but not yet used), whether the end
+// of the journal has been reached (or reading was abandoned) and the
+// joystick direction (or -1)
+static JournalRecord next_record;
+static uint8_t have_next_record;
+static uint8_t replay_ended;
+static uint8_t replay_abandoned;
+static int8_t replay_held_direction;
+
+static void add_record(uint8_t type, uint32_t tick, uint16_t value) {
+	if(queue_length == JOURNAL_QUEUE_SIZE) {
+		// Make room - records must not be lost
+		journal_flush();
+	}
+	JournalRecord* record = &queue[(queue_start + queue_length) % JOURNAL_QUEUE_SIZE];
+	record->type = type;
+	record->tick = tick;
+	record->value = value;
+	queue_length++;
+}
+
+void journal_start(uint16_t seed) {
+	recording = 1;
+	recorded_held_direction = -1;
+	add_record(RECORD_START, 0, seed);
+}
+
+void journal_input(uint32_t tick, int8_t held_direction, int8_t pushed_direction) {
+	if(!recording) {
+		return;
+	}
+	if(held_direction != recorded_held_direction) {
+		if(held_direction < 0) {
+			add_record(JOURNAL_HELD_NONE, tick, 0);
+		} else {
+			add_record(JOURNAL_HELD_LEFT + held_direction, tick, 0);
+		}
+		recorded_held_direction = held_direction;
+	}
+	// A push only makes a difference if the joystick isn't being held
+	if(pushed_direction >= 0 && held_direction < 0) {
+		add_record(JOURNAL_PUSHED_LEFT + pushed_direction, tick, 0);
+	}
+}
+
+void journal_record(uint32_t tick, uint8_t event) {
+	if(recording) {
+		add_record(event, tick, 0);
+	}
+}
+
+void journal_end(uint32_t ticks, uint16_t checksum) {
+	if(recording) {
+		add_record(RECORD_END, ticks, checksum);
+		recording = 0;
+	}
+}
+
+void journal_flush(void) {
+	while(queue_length > 0) {
+		JournalRecord* record = &queue[queue_start];
+		if(record->type == RECORD_START) {
+			printf_P(PSTR("\x1b_J S %u\x1b\\"), record->value);
+		} else if(record->type == RECORD_END) {
+			printf_P(PSTR("\x1b_J E %lu %u\x1b\\"), record->tick, record->value);
+		} else {
+			printf_P(PSTR("\x1b_J %lu %u\x1b\\"), record->tick, record->type);
+		}
+		queue_start = (queue_start + 1) % JOURNAL_QUEUE_SIZE;
+		queue_length--;
+	}
+}
+
+// Ask for the next record and read it from the serial port into
+// next_record. Returns 0 if it couldn't be read (escape was pressed instead,
+// e.g. because nothing is sending the records) - no more are read after that.
+static uint8_t read_record(void) {
+	char line[RECORD_LINE_SIZE];
+	uint8_t length = 0;
+	if(replay_abandoned) {
+		return 0;
+	}
+	printf_P(PSTR("\x1b_J ?\x1b\\"));
+	for(;;) {
+		int c = fgetc(stdin);
+		if(c == ESCAPE_CHAR) {
+			replay_abandoned = 1;
+			return 0;
+		} else if(c == '\n' || c == '\r') {
+			if(length > 0) {
+				break;
+			}
+		} else if(length < RECORD_LINE_SIZE - 1) {
+			line[length++] = c;
+		}
+	}
+	line[length] = 0;
+	char* rest;
+	if(line[0] == RECORD_START || line[0] == RECORD_END) {
+		next_record.type = line[0];
+		if(line[0] == RECORD_START) {
+			next_record.tick = 0;
+			next_record.value = strtoul(line + 1, &rest, 10);
+		} else {
+			next_record.tick = strtoul(line + 1, &rest, 10);
+			next_record.value = strtoul(rest, &rest, 10);
+		}
+	} else {
+		next_record.tick = strtoul(line, &rest, 10);
+		next_record.type = strtoul(rest, &rest, 10);
+	}
+	have_next_record = 1;
+	return 1;
+}
+
+uint8_t journal_replay_start(uint16_t* seed) {
+	clear_serial_input_buffer();
+	replay_ended = 0;
+	replay_abandoned = 0;
+	replay_held_direction = -1;
+	have_next_record = 0;
+	if(!read_record() || next_record.type != RECORD_START) {
+		replay_ended = 1;
+		return 0;
+	}
+	*seed = next_record.value;
+	have_next_record = 0;
+	return 1;
+}
+
+uint8_t journal_replay_input(uint32_t tick, int8_t* held_direction,
+		int8_t* pushed_direction) {
+	*held_direction = -1;
+	*pushed_direction = -1;
+	while(!replay_ended) {
+		if(!have_next_record && !read_record()) {
+			replay_ended = 1;
+			break;
+		}
+		uint8_t type = next_record.type;
+		if(type == RECORD_START) {
+			// Next game - this one wasn't ended properly
+			replay_ended = 1;
+			break;
+		}
+		if(next_record.tick > tick) {
+			// Nothing more happens at this tick
+			*held_direction = replay_held_direction;
+			return 1;
+		}
+		if(type == RECORD_END || type == JOURNAL_LOADED) {
+			// The journal stops here (the end record is kept for
+			// journal_replay_end())
+			replay_ended = 1;
+			break;
+		}
+		if(type < JOURNAL_HELD_NONE) {
+			replay_held_direction = type - JOURNAL_HELD_LEFT;
+		} else if(type == JOURNAL_HELD_NONE) {
+			replay_held_direction = -1;
+		} else if(type >= JOURNAL_PUSHED_LEFT && type < JOURNAL_PUSHED_LEFT + 4) {
+			*pushed_direction = type - JOURNAL_PUSHED_LEFT;
+		}
+		have_next_record = 0;
+	}
+	return 0;
+}
+
+uint8_t journal_replay_end(uint32_t ticks, uint16_t checksum) {
+	// Skip any input recorded after the game ended
+	while((have_next_record || read_record()) && next_record.type != RECORD_END
+			&& next_record.type != RECORD_START && next_record.type != JOURNAL_LOADED) {
+		have_next_record = 0;
+	}
+	replay_ended = 1;
+	return have_next_record && next_record.type == RECORD_END
+			&& next_record.tick == ticks && next_record.value == checksum;
+}
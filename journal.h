@@ -0,0 +1,77 @@
+/*
+ * journal.h
+ *
+ * Author: Joel Foster
+ *
+ * Journal of the input to a game, so that the game can be played again
+ * exactly as it was (e.g. to reproduce a bug, or as a repeatable workload
+ * for timing). Since the game moves on a tick at a time (see game_step()
+ * in game.h) and its only other input is the random number seed, the seed
+ * and the input at each tick are all that is needed.
+ *
+ * Records are kept in a small queue and sent over the serial port by
+ * journal_flush(), each one wrapped in an "application program command"
+ * escape sequence (ESC _ J record ESC \) which terminals don't display.
+ * The records are lines of text:
+ *	S seed				a new game starting with the given seed
+ *	tick event			input event (JOURNAL_ values below) at the start
+ *						of the given tick (ticks count from 0)
+ *	E tick checksum		game ended (or was abandoned) after the given
+ *						number of ticks, with the given get_game_checksum()
+ * tools/replay.c picks the records out of a capture of the serial output
+ * and replays the game on the development computer, or sends them back to
+ * the board (which asks for each record with ESC _ J ? ESC \ when it needs
+ * it) to replay the game there - see journal_replay_start().
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdint.h>
+
+// Events. Only changes to the joystick are recorded (the joystick is held
+// in a direction from that tick until the next joystick event).
+#define JOURNAL_HELD_LEFT 0		// joystick held in direction (DIRN_ values)
+#define JOURNAL_HELD_NONE 4		// joystick released
+#define JOURNAL_PUSHED_LEFT 8	// button or cursor key pushed (+ DIRN_ value)
+#define JOURNAL_LOADED 16		// game loaded from EEPROM or stepped back (see
+								// rewind.h) - can't be replayed beyond this
+								// point
+
+// Number of records that can be waiting to be sent
+#define JOURNAL_QUEUE_SIZE 8
+
+// Start the journal of a new game that uses the given random number seed
+void journal_start(uint16_t seed);
+
+// Record the input for the given tick - the direction the joystick is
+// held in and the direction pushed (each -1 if none, as for game_step())
+void journal_input(uint32_t tick, int8_t held_direction, int8_t pushed_direction);
+
+// Record an event at the given tick
+void journal_record(uint32_t tick, uint8_t event);
+
+// End the journal of the current game (if one was started), which ended
+// after the given number of ticks with the given game checksum
+void journal_end(uint32_t ticks, uint16_t checksum);
+
+// Send any records waiting in the queue over the serial port
+void journal_flush(void);
+
+// Start replaying a game from records sent over the serial port (any
+// input still waiting is discarded first). Returns 1 and sets *seed to the
+// game's seed if a new game record was received, 0 otherwise.
+uint8_t journal_replay_start(uint16_t* seed);
+
+// Get the input for the given tick of the game being replayed (reading more
+// records as needed). Returns 0 (with no input) if the journal has ended
+// before this tick, 1 otherwise.
+uint8_t journal_replay_input(uint32_t tick, int8_t* held_direction,
+		int8_t* pushed_direction);
+
+// Finish the replay of a game that ended after the given number of ticks
+// with the given checksum. Returns 1 if the journal ended in exactly the
+// same way, 0 if not.
+uint8_t journal_replay_end(uint32_t ticks, uint16_t checksum);
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,120 @@
+/*
+ * joystick.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "joystick.h"
+
+#if JOYSTICK_OVERSAMPLE > 64
+#error "JOYSTICK_OVERSAMPLE must be at most 64"
+#endif
+
+// ADC channel of each axis
+#define X_AXIS 0
+#define Y_AXIS 1
+
+// The axis being read, the sum of its readings so far and how many there
+// have been
+static uint8_t axis;
+static uint16_t sum;
+static uint8_t samples;
+
+// Averaged reading of the X axis (kept until the Y axis has been read)
+static uint16_t x_reading;
+
+// Resting readings of the axes, and 1 if the next readings are to be taken
+// as the resting position
+static uint16_t resting_x;
+static uint16_t resting_y;
+static volatile uint8_t calibrating;
+
+static volatile uint8_t position;
+static volatile uint16_t noise;
+
+// Start a conversion of the given axis
+static void start_conversion(uint8_t channel) {
+	// AVCC reference
+	ADMUX = (1<<REFS0) | channel;
+	ADCSRA |= (1<<ADSC);
+}
+
+void joystick_init(void) {
+	axis = X_AXIS;
+	sum = 0;
+	samples = 0;
+	position = 0;
+	calibrating = 1;
+	// Clock divided by 128 (62.5kHz) - a conversion every 208us
+	ADCSRA = (1<<ADEN)|(1<<ADIE)|(1<<ADPS2)|(1<<ADPS1)|(1<<ADPS0);
+	start_conversion(axis);
+}
+
+void joystick_calibrate(void) {
+	calibrating = 1;
+}
+
+uint8_t joystick_position(void) {
+	return position;
+}
+
+uint16_t joystick_noise(void) {
+	uint16_t value;
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	value = noise;
+	if(interrupts_were_enabled) {
+		sei();
+	}
+	return value;
+}
+
+// Returns the new state of the given pair of position bits for an axis
+// reading - low_bit is set if the reading is below the resting reading,
+// high_bit if it is above. A bit that is already set stays set until the
+// reading is back inside the smaller (released) deadzone.
+static uint8_t axis_position(uint16_t reading, uint16_t resting,
+		uint8_t low_bit, uint8_t high_bit) {
+	int16_t offset = reading - resting;
+	uint8_t bits = position & (low_bit | high_bit);
+	if(offset > JOYSTICK_DEADZONE) {
+		return high_bit;
+	} else if(offset < -JOYSTICK_DEADZONE) {
+		return low_bit;
+	} else if(offset > JOYSTICK_DEADZONE - JOYSTICK_HYSTERESIS) {
+		return bits & high_bit;
+	} else if(offset < -(JOYSTICK_DEADZONE - JOYSTICK_HYSTERESIS)) {
+		return bits & low_bit;
+	}
+	return 0;
+}
+
+// Interrupt handler for an ADC conversion being complete - add the reading
+// to its axis and start the next conversion
+ISR(ADC_vect) {
+	uint16_t reading = ADC;
+	noise = ((noise << 1) | (noise >> 15)) ^ reading;
+	sum += reading;
+	if(++samples == JOYSTICK_OVERSAMPLE) {
+		reading = sum / JOYSTICK_OVERSAMPLE;
+		sum = 0;
+		samples = 0;
+		if(axis == X_AXIS) {
+			x_reading = reading;
+			axis = Y_AXIS;
+		} else {
+			// Both axes have been read
+			if(calibrating) {
+				resting_x = x_reading;
+				resting_y = reading;
+				calibrating = 0;
+			}
+			position = axis_position(x_reading, resting_x, JOYSTICK_LEFT, JOYSTICK_RIGHT)
+					| axis_position(reading, resting_y, JOYSTICK_DOWN, JOYSTICK_UP);
+			axis = X_AXIS;
+		}
+	}
+	start_conversion(axis);
+}
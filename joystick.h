@@ -0,0 +1,53 @@
+/*
+ * joystick.h
+ *
+ * Author: Joel Foster
+ *
+ * Reads the joystick (X on ADC0, Y on ADC1) in the background. Each ADC
+ * conversion complete interrupt starts the next conversion, alternating
+ * between the two axes, and each axis is the average of
+ * JOYSTICK_OVERSAMPLE readings. An axis only counts as pushed once it is
+ * more than JOYSTICK_DEADZONE from its resting reading (found by
+ * joystick_calibrate()), and then stays pushed until it is back within
+ * JOYSTICK_DEADZONE - JOYSTICK_HYSTERESIS - so noise near the edge of the
+ * deadzone doesn't keep changing the direction. The position is kept up to
+ * date by the interrupt handler so reading it never waits for the ADC.
+ */
+
+#ifndef JOYSTICK_H_
+#define JOYSTICK_H_
+
+#include <stdint.h>
+
+// Readings averaged for each axis (at most 64, so the sum fits in 16 bits)
+#define JOYSTICK_OVERSAMPLE 16
+
+// Distance (in ADC counts, out of 1023) an axis must move from its resting
+// reading to count as pushed, and how much closer it must come back to
+// count as released
+#define JOYSTICK_DEADZONE 128
+#define JOYSTICK_HYSTERESIS 32
+
+// Bits of joystick_position() - none are set when the joystick is resting,
+// and up to two (e.g. JOYSTICK_UP|JOYSTICK_LEFT) when it is pushed diagonally
+#define JOYSTICK_LEFT 0x01
+#define JOYSTICK_RIGHT 0x02
+#define JOYSTICK_UP 0x04
+#define JOYSTICK_DOWN 0x08
+
+// Set up the ADC and start sampling - global interrupts must be enabled
+// after this is called
+void joystick_init(void);
+
+// Take the next readings of the axes as the resting position (the joystick
+// is taken to be resting until they have been made)
+void joystick_calibrate(void);
+
+// Returns the latest position of the joystick (the JOYSTICK_ bits above)
+uint8_t joystick_position(void);
+
+// Returns a value made from the low (noisy) bits of every reading so far -
+// for seeding the random number generator
+uint16_t joystick_noise(void);
+
+#endif /* JOYSTICK_H_ */
@@ -1,116 +1,401 @@
-/*
- * ledmatrix.c
- *
- * Author: Peter Sutton
- * 
- * See the LED matrix Reference for details of the SPI commands used.
- */ 
-
-#include <avr/io.h>
-#include "ledmatrix.h"
-#include "spi.h"
-
-#define CMD_UPDATE_ALL 0x00
-#define CMD_UPDATE_PIXEL 0x01
-#define CMD_UPDATE_ROW 0x02
-#define CMD_UPDATE_COL 0x03
-#define CMD_SHIFT_DISPLAY 0x04
-#define CMD_CLEAR_SCREEN 0x0F
-
-void ledmatrix_setup(void) {
-	// Setup SPI - we divide the clock by 128.
-	// (This speed guarantees the SPI buffer will never overflow on
-	// the LED matrix.)
-	spi_setup_master(128);
-}
-
-void ledmatrix_update_all(MatrixData data) {
-	(void)spi_send_byte(CMD_UPDATE_ALL);
-	for(uint8_t y=0; y<MATRIX_NUM_ROWS; y++) {
-		for(uint8_t x=0; x<MATRIX_NUM_COLUMNS; x++) {
-			(void)spi_send_byte(data[x][y]);
-		}
-	}
-}
-
-void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel) {
-	if(x >= MATRIX_NUM_COLUMNS || y >= MATRIX_NUM_ROWS) {
-		// Position isn't valid - we ignore the request.
-		return;
-	}
-	(void)spi_send_byte(CMD_UPDATE_PIXEL);
-	(void)spi_send_byte( ((y & 0x07)<<4) | (x & 0x0F));
-	(void)spi_send_byte(pixel);
-}
-
-void ledmatrix_update_row(uint8_t y, MatrixRow row) {
-	if(y >= MATRIX_NUM_ROWS) {
-		// y value is too large - we ignore the request
-		return;
-	}
-	(void)spi_send_byte(CMD_UPDATE_ROW);
-	(void)spi_send_byte(y & 0x07);	// row number
-	for(uint8_t x = 0; x<MATRIX_NUM_COLUMNS; x++) {
-		(void)spi_send_byte(row[x]);
-	}
-}
-
-void ledmatrix_update_column(uint8_t x, MatrixColumn col) {
-	if(x >= MATRIX_NUM_COLUMNS) {
-		// x value is too large - we ignore the request
-		return;
-	}
-	(void)spi_send_byte(CMD_UPDATE_COL);
-	(void)spi_send_byte(x & 0x0F); // column number
-	for(uint8_t y = 0; y<MATRIX_NUM_ROWS; y++) {
-		(void)spi_send_byte(col[y]);
-	}
-}
-
-void ledmatrix_shift_display_left(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x02);
-}
-
-void ledmatrix_shift_display_right(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x01);
-}
-
-void ledmatrix_shift_display_up(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x08);
-}
-
-void ledmatrix_shift_display_down(void) {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x04);
-}
-
-void ledmatrix_clear(void) {
-	(void)spi_send_byte(CMD_CLEAR_SCREEN);
-}
-
-void copy_matrix_column(MatrixColumn from, MatrixColumn to) {
-	for(uint8_t row = 0; row <MATRIX_NUM_ROWS; row++) {
-		to[row] = from[row];
-	}
-}
-
-void copy_matrix_row(MatrixRow from, MatrixRow to) {
-	for(uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
-		to[col] = from[col];
-	}
-}
-
-void set_matrix_column_to_colour(MatrixColumn matrix_column, PixelColour colour) {
-	for(uint8_t row = 0; row < MATRIX_NUM_ROWS; row++) {
-		matrix_column[row] = colour;
-	}
-}
-
-void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour) {
-	for(uint8_t column = 0; column < MATRIX_NUM_COLUMNS; column++) {
-		matrix_row[column] = colour;
-	}
-}
+/*
+ * ledmatrix.c
+ *
+ * Author: Peter Sutton
+ * 
+ * See the LED matrix Reference for details of the SPI commands used.
+ */ 
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+#include "ledmatrix.h"
+#include "spi.h"
+
+#define CMD_UPDATE_ALL 0x00
+#define CMD_UPDATE_PIXEL 0x01
+#define CMD_UPDATE_ROW 0x02
+#define CMD_UPDATE_COL 0x03
+#define CMD_SHIFT_DISPLAY 0x04
+#define CMD_CLEAR_SCREEN 0x0F
+
+// Number of SPI bytes each command takes
+#define PIXEL_BYTES 3
+#define ROW_BYTES (2 + MATRIX_NUM_COLUMNS)
+#define COLUMN_BYTES (2 + MATRIX_NUM_ROWS)
+#define ALL_BYTES (1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS)
+#define SHIFT_BYTES 2
+#define CLEAR_BYTES 1
+
+// The frame buffer - what the display shows once everything has been
+// flushed. Bit x of dirty[y] is set if pixel (x,y) may differ from what the
+// display shows (after the shifts waiting to be sent).
+static MatrixData frame;
+static uint16_t dirty[MATRIX_NUM_ROWS];
+
+// Shifts made to the frame buffer that haven't been sent yet (the
+// argument of each shift command). If there are too many to keep the
+// whole frame is marked as dirty instead.
+#define MAX_PENDING_SHIFTS 4
+static uint8_t pending_shifts[MAX_PENDING_SHIFTS];
+static uint8_t num_pending_shifts;
+
+// The commands chosen to send a set of pixels: the rows and columns sent
+// in full (bit y of rows, bit x of columns) - the other pixels are sent
+// one at a time - and the number of bytes they take
+typedef struct {
+	uint8_t rows;
+	uint16_t columns;
+	uint16_t bytes;
+} Cover;
+
+uint8_t ledmatrix_setup(void) {
+	// Setup SPI - we divide the clock by 128.
+	// (This speed guarantees the SPI buffer will never overflow on
+	// the LED matrix.)
+	return spi_setup_master(128);
+}
+
+void ledmatrix_wait(void) {
+	spi_flush();
+}
+
+// Number of bits set in each byte value - the cover search counts bits a
+// lot, so one table lookup each is worth the flash
+#define POPCOUNT_2(n) (n), (n) + 1, (n) + 1, (n) + 2
+#define POPCOUNT_4(n) POPCOUNT_2(n), POPCOUNT_2((n) + 1), \
+		POPCOUNT_2((n) + 1), POPCOUNT_2((n) + 2)
+#define POPCOUNT_6(n) POPCOUNT_4(n), POPCOUNT_4((n) + 1), \
+		POPCOUNT_4((n) + 1), POPCOUNT_4((n) + 2)
+static const uint8_t byte_popcount[256] PROGMEM = {
+	POPCOUNT_6(0), POPCOUNT_6(1), POPCOUNT_6(1), POPCOUNT_6(2)
+};
+
+// Returns the number of bits set in value
+static uint8_t count_bits(uint8_t value) {
+	return pgm_read_byte(&byte_popcount[value]);
+}
+
+// Work out the cheapest way to send the pixels in the given set (bit x of
+// pixels[y] for pixel (x,y)) using pixel, row and column updates. Sending a
+// row is only worth it if it has more pixels than the same bytes would send
+// one at a time (and the same for a column), so only the subsets of those
+// rows need to be tried - for each one the best choice for each column is
+// then clear.
+static void find_cover(const uint16_t pixels[MATRIX_NUM_ROWS], Cover* best) {
+	uint8_t columns[MATRIX_NUM_COLUMNS];	// bit y set for each pixel
+	uint8_t candidate_rows = 0;
+	memset(columns, 0, sizeof(columns));
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		if((count_bits(pixels[y] & 0xFF) + count_bits(pixels[y] >> 8))
+				* PIXEL_BYTES > ROW_BYTES) {
+			candidate_rows |= (1<<y);
+		}
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			if(pixels[y] & (1<<x)) {
+				columns[x] |= (1<<y);
+			}
+		}
+	}
+	best->bytes = UINT16_MAX;
+	// Each subset of the candidate rows in turn (ending with none)
+	uint8_t rows = candidate_rows;
+	do {
+		uint16_t bytes = count_bits(rows) * ROW_BYTES;
+		uint16_t chosen_columns = 0;
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS && bytes < best->bytes; x++) {
+			uint8_t pixel_bytes = count_bits(columns[x] & ~rows) * PIXEL_BYTES;
+			if(pixel_bytes > COLUMN_BYTES) {
+				chosen_columns |= (1<<x);
+				bytes += COLUMN_BYTES;
+			} else {
+				bytes += pixel_bytes;
+			}
+		}
+		if(bytes < best->bytes) {
+			best->rows = rows;
+			best->columns = chosen_columns;
+			best->bytes = bytes;
+		}
+		rows = (rows - 1) & candidate_rows;
+	} while(rows != candidate_rows);
+}
+
+// Send the pixels in the given set using the commands chosen for them
+static void send_cover(const uint16_t pixels[MATRIX_NUM_ROWS], const Cover* cover) {
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		if(cover->rows & (1<<y)) {
+			spi_queue_byte(CMD_UPDATE_ROW);
+			spi_queue_byte(y);
+			for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+				spi_queue_byte(frame[x][y]);
+			}
+		}
+	}
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		if(cover->columns & (1<<x)) {
+			spi_queue_byte(CMD_UPDATE_COL);
+			spi_queue_byte(x);
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				spi_queue_byte(frame[x][y]);
+			}
+		}
+	}
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		if(cover->rows & (1<<y)) {
+			continue;
+		}
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			if((pixels[y] & (1<<x)) && !(cover->columns & (1<<x))) {
+				spi_queue_byte(CMD_UPDATE_PIXEL);
+				spi_queue_byte((y<<4) | x);
+				spi_queue_byte(frame[x][y]);
+			}
+		}
+	}
+}
+
+// Shift the frame buffer (and which pixels are dirty) the same way the
+// display is shifted by the shift command with the given argument. The
+// row or column shifted in is blank.
+static void shift_frame(uint8_t direction) {
+	switch(direction) {
+		case LEDMATRIX_SHIFT_LEFT:
+			memmove(frame[0], frame[1], sizeof(frame) - sizeof(frame[0]));
+			memset(frame[MATRIX_NUM_COLUMNS - 1], 0, sizeof(frame[0]));
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				dirty[y] >>= 1;
+			}
+			break;
+		case LEDMATRIX_SHIFT_RIGHT:
+			memmove(frame[1], frame[0], sizeof(frame) - sizeof(frame[0]));
+			memset(frame[0], 0, sizeof(frame[0]));
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				dirty[y] <<= 1;
+			}
+			break;
+		case LEDMATRIX_SHIFT_UP:
+			for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+				memmove(&frame[x][1], &frame[x][0], MATRIX_NUM_ROWS - 1);
+				frame[x][0] = 0;
+			}
+			memmove(&dirty[1], &dirty[0], sizeof(dirty) - sizeof(dirty[0]));
+			dirty[0] = 0;
+			break;
+		case LEDMATRIX_SHIFT_DOWN:
+			for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+				memmove(&frame[x][0], &frame[x][1], MATRIX_NUM_ROWS - 1);
+				frame[x][MATRIX_NUM_ROWS - 1] = 0;
+			}
+			memmove(&dirty[0], &dirty[1], sizeof(dirty) - sizeof(dirty[0]));
+			dirty[MATRIX_NUM_ROWS - 1] = 0;
+			break;
+	}
+}
+
+// Send the shifts made to the frame buffer that haven't been sent yet
+static void send_pending_shifts(void) {
+	for(uint8_t i = 0; i < num_pending_shifts; i++) {
+		spi_queue_byte(CMD_SHIFT_DISPLAY);
+		spi_queue_byte(pending_shifts[i]);
+	}
+	num_pending_shifts = 0;
+}
+
+void ledmatrix_set_pixel(uint8_t x, uint8_t y, PixelColour pixel) {
+	if(x >= MATRIX_NUM_COLUMNS || y >= MATRIX_NUM_ROWS || frame[x][y] == pixel) {
+		return;
+	}
+	frame[x][y] = pixel;
+	dirty[y] |= (1<<x);
+}
+
+PixelColour ledmatrix_get_pixel(uint8_t x, uint8_t y) {
+	if(x >= MATRIX_NUM_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		return COLOUR_BLACK;
+	}
+	return frame[x][y];
+}
+
+void ledmatrix_shift_frame(uint8_t direction) {
+	shift_frame(direction);
+	if(num_pending_shifts < MAX_PENDING_SHIFTS) {
+		pending_shifts[num_pending_shifts++] = direction;
+	} else {
+		// Too many to keep - send the whole frame instead
+		num_pending_shifts = 0;
+		memset(dirty, 0xFF, sizeof(dirty));
+	}
+}
+
+void ledmatrix_flush(void) {
+	uint8_t anything_dirty = num_pending_shifts;
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		anything_dirty |= (dirty[y] != 0);
+	}
+	if(!anything_dirty) {
+		return;
+	}
+	// The choices are: the shifts and then the dirty pixels, clearing the
+	// display and then the pixels that aren't black, or the whole frame
+	uint16_t lit[MATRIX_NUM_ROWS];
+	uint8_t lit_count = 0;
+	Cover dirty_cover, lit_cover;
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		lit[y] = 0;
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			if(frame[x][y] != COLOUR_BLACK) {
+				lit[y] |= (1<<x);
+				lit_count++;
+			}
+		}
+	}
+	find_cover(dirty, &dirty_cover);
+	dirty_cover.bytes += num_pending_shifts * SHIFT_BYTES;
+	// No command sends a pixel for less than a row does (ROW_BYTES for
+	// MATRIX_NUM_COLUMNS pixels), so clearing the display can't cost less
+	// than this - only search for the best way to do it if that would win
+	uint16_t lit_bytes_at_least = CLEAR_BYTES + ((uint16_t)lit_count
+			* ROW_BYTES + MATRIX_NUM_COLUMNS - 1) / MATRIX_NUM_COLUMNS;
+	if(dirty_cover.bytes > lit_bytes_at_least) {
+		find_cover(lit, &lit_cover);
+		lit_cover.bytes += CLEAR_BYTES;
+	} else {
+		lit_cover.bytes = UINT16_MAX;
+	}
+	if(dirty_cover.bytes <= lit_cover.bytes && dirty_cover.bytes <= ALL_BYTES) {
+		send_pending_shifts();
+		send_cover(dirty, &dirty_cover);
+	} else if(lit_cover.bytes <= ALL_BYTES) {
+		spi_queue_byte(CMD_CLEAR_SCREEN);
+		send_cover(lit, &lit_cover);
+	} else {
+		spi_queue_byte(CMD_UPDATE_ALL);
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+				spi_queue_byte(frame[x][y]);
+			}
+		}
+	}
+	num_pending_shifts = 0;
+	memset(dirty, 0, sizeof(dirty));
+}
+
+void ledmatrix_update_all(MatrixData data) {
+	// Everything is replaced, so the shifts waiting don't matter
+	memcpy(frame, data, sizeof(frame));
+	memset(dirty, 0, sizeof(dirty));
+	num_pending_shifts = 0;
+	spi_queue_byte(CMD_UPDATE_ALL);
+	for(uint8_t y=0; y<MATRIX_NUM_ROWS; y++) {
+		for(uint8_t x=0; x<MATRIX_NUM_COLUMNS; x++) {
+			spi_queue_byte(data[x][y]);
+		}
+	}
+}
+
+void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel) {
+	if(x >= MATRIX_NUM_COLUMNS || y >= MATRIX_NUM_ROWS) {
+		// Position isn't valid - we ignore the request.
+		return;
+	}
+	send_pending_shifts();
+	frame[x][y] = pixel;
+	dirty[y] &= ~(1<<x);
+	spi_queue_byte(CMD_UPDATE_PIXEL);
+	spi_queue_byte( ((y & 0x07)<<4) | (x & 0x0F));
+	spi_queue_byte(pixel);
+}
+
+void ledmatrix_update_row(uint8_t y, MatrixRow row) {
+	if(y >= MATRIX_NUM_ROWS) {
+		// y value is too large - we ignore the request
+		return;
+	}
+	send_pending_shifts();
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		frame[x][y] = row[x];
+	}
+	dirty[y] = 0;
+	spi_queue_byte(CMD_UPDATE_ROW);
+	spi_queue_byte(y & 0x07);	// row number
+	for(uint8_t x = 0; x<MATRIX_NUM_COLUMNS; x++) {
+		spi_queue_byte(row[x]);
+	}
+}
+
+void ledmatrix_update_column(uint8_t x, MatrixColumn col) {
+	if(x >= MATRIX_NUM_COLUMNS) {
+		// x value is too large - we ignore the request
+		return;
+	}
+	send_pending_shifts();
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		frame[x][y] = col[y];
+		dirty[y] &= ~(1<<x);
+	}
+	spi_queue_byte(CMD_UPDATE_COL);
+	spi_queue_byte(x & 0x0F); // column number
+	for(uint8_t y = 0; y<MATRIX_NUM_ROWS; y++) {
+		spi_queue_byte(col[y]);
+	}
+}
+
+void ledmatrix_shift_display_left(void) {
+	send_pending_shifts();
+	shift_frame(LEDMATRIX_SHIFT_LEFT);
+	spi_queue_byte(CMD_SHIFT_DISPLAY);
+	spi_queue_byte(LEDMATRIX_SHIFT_LEFT);
+}
+
+void ledmatrix_shift_display_right(void) {
+	send_pending_shifts();
+	shift_frame(LEDMATRIX_SHIFT_RIGHT);
+	spi_queue_byte(CMD_SHIFT_DISPLAY);
+	spi_queue_byte(LEDMATRIX_SHIFT_RIGHT);
+}
+
+void ledmatrix_shift_display_up(void) {
+	send_pending_shifts();
+	shift_frame(LEDMATRIX_SHIFT_UP);
+	spi_queue_byte(CMD_SHIFT_DISPLAY);
+	spi_queue_byte(LEDMATRIX_SHIFT_UP);
+}
+
+void ledmatrix_shift_display_down(void) {
+	send_pending_shifts();
+	shift_frame(LEDMATRIX_SHIFT_DOWN);
+	spi_queue_byte(CMD_SHIFT_DISPLAY);
+	spi_queue_byte(LEDMATRIX_SHIFT_DOWN);
+}
+
+void ledmatrix_clear(void) {
+	memset(frame, 0, sizeof(frame));
+	memset(dirty, 0, sizeof(dirty));
+	num_pending_shifts = 0;
+	spi_queue_byte(CMD_CLEAR_SCREEN);
+}
+
+void copy_matrix_column(MatrixColumn from, MatrixColumn to) {
+	for(uint8_t row = 0; row <MATRIX_NUM_ROWS; row++) {
+		to[row] = from[row];
+	}
+}
+
+void copy_matrix_row(MatrixRow from, MatrixRow to) {
+	for(uint8_t col = 0; col < MATRIX_NUM_COLUMNS; col++) {
+		to[col] = from[col];
+	}
+}
+
+void set_matrix_column_to_colour(MatrixColumn matrix_column, PixelColour colour) {
+	for(uint8_t row = 0; row < MATRIX_NUM_ROWS; row++) {
+		matrix_column[row] = colour;
+	}
+}
+
+void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour) {
+	for(uint8_t column = 0; column < MATRIX_NUM_COLUMNS; column++) {
+		matrix_row[column] = colour;
+	}
+}
@@ -1,50 +1,77 @@
-/*
- * ledmatrix.h
- *
- * Author: Peter Sutton
- */ 
-
-
-#ifndef LEDMATRIX_H_
-#define LEDMATRIX_H_
-
-#include <stdint.h>
-#include "pixel_colour.h"
-
-// The matrix has 16 columns (x ranges from 0 to 15, left to right) and 
-// 8 rows (y ranges from 0 to 7, bottom to top) - as per the X,Y
-// coordinates marked on the board.
-#define MATRIX_NUM_COLUMNS 16
-#define MATRIX_NUM_ROWS 8
-
-// Data types which can be used to store display information
-typedef PixelColour MatrixData[MATRIX_NUM_COLUMNS][MATRIX_NUM_ROWS];
-typedef PixelColour MatrixRow[MATRIX_NUM_COLUMNS];
-typedef PixelColour MatrixColumn[MATRIX_NUM_ROWS];
-
-// Setup SPI communication with the LED matrix.
-// This function must be called before the LED matrix functions
-// below are used.
-void ledmatrix_setup(void);
-
-// Functions to update the display
-// For those functions which take an x or a y value, the value must be valid
-// or the request will be ignored. (i.e. x must be < MATRIX_NUM_COLUMNS
-// and y must be < MATRIX_NUM_ROWS)
-void ledmatrix_update_all(MatrixData data);
-void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel);
-void ledmatrix_update_row(uint8_t y, MatrixRow row);
-void ledmatrix_update_column(uint8_t x, MatrixColumn col);
-void ledmatrix_shift_display_left(void);
-void ledmatrix_shift_display_right(void);
-void ledmatrix_shift_display_up(void);
-void ledmatrix_shift_display_down(void);
-void ledmatrix_clear(void);
-
-// Functions to operate on MatrixRow and MatrixColumn data structures
-void copy_matrix_column(MatrixColumn from, MatrixColumn to);
-void copy_matrix_row(MatrixRow from, MatrixRow to);
-void set_matrix_column_to_colour(MatrixColumn matrix_column, PixelColour colour);
-void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour);
-
-#endif /* LEDMATRIX_H_ */
+/*
+ * ledmatrix.h
+ *
+ * Author: Peter Sutton
+ */ 
+
+
+#ifndef LEDMATRIX_H_
+#define LEDMATRIX_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// The matrix has 16 columns (x ranges from 0 to 15, left to right) and 
+// 8 rows (y ranges from 0 to 7, bottom to top) - as per the X,Y
+// coordinates marked on the board.
+#define MATRIX_NUM_COLUMNS 16
+#define MATRIX_NUM_ROWS 8
+
+// Data types which can be used to store display information
+typedef PixelColour MatrixData[MATRIX_NUM_COLUMNS][MATRIX_NUM_ROWS];
+typedef PixelColour MatrixRow[MATRIX_NUM_COLUMNS];
+typedef PixelColour MatrixColumn[MATRIX_NUM_ROWS];
+
+// Setup SPI communication with the LED matrix.
+// This function must be called before the LED matrix functions
+// below are used.
+// Returns 1 if successful, 0 if the SPI pins have already been claimed
+// (see ports.h).
+uint8_t ledmatrix_setup(void);
+
+// The functions below queue their SPI bytes (see spi.h) and return without
+// waiting for them to be sent - the commands reach the LED matrix in the
+// order they were made. ledmatrix_update_all() has more bytes than fit in
+// the queue, so it returns once all but the last SPI_QUEUE_SIZE have been
+// sent. ledmatrix_wait() waits until every command has been sent.
+void ledmatrix_wait(void);
+
+// Functions to update the display straight away (the frame buffer below
+// is kept up to date too)
+// For those functions which take an x or a y value, the value must be valid
+// or the request will be ignored. (i.e. x must be < MATRIX_NUM_COLUMNS
+// and y must be < MATRIX_NUM_ROWS)
+void ledmatrix_update_all(MatrixData data);
+void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel);
+void ledmatrix_update_row(uint8_t y, MatrixRow row);
+void ledmatrix_update_column(uint8_t x, MatrixColumn col);
+void ledmatrix_shift_display_left(void);
+void ledmatrix_shift_display_right(void);
+void ledmatrix_shift_display_up(void);
+void ledmatrix_shift_display_down(void);
+void ledmatrix_clear(void);
+
+// Frame buffer - a copy of what is on the display. Pixels can be set (and
+// the frame shifted) in any order and as often as needed - nothing is sent
+// until ledmatrix_flush(), which sends only the pixels that have changed
+// using whichever mix of shift, pixel, row, column, clear and update all
+// commands takes the fewest SPI bytes. Setting a pixel to the colour it
+// already has costs nothing.
+#define LEDMATRIX_SHIFT_RIGHT 0x01
+#define LEDMATRIX_SHIFT_LEFT 0x02
+#define LEDMATRIX_SHIFT_DOWN 0x04
+#define LEDMATRIX_SHIFT_UP 0x08
+void ledmatrix_set_pixel(uint8_t x, uint8_t y, PixelColour pixel);
+PixelColour ledmatrix_get_pixel(uint8_t x, uint8_t y);
+// Shift the frame one pixel in the given direction (one of the above) -
+// the row or column shifted in is blank. This is sent as a shift command.
+void ledmatrix_shift_frame(uint8_t direction);
+void ledmatrix_flush(void);
+
+// Functions to operate on MatrixRow and MatrixColumn data structures
+void copy_matrix_column(MatrixColumn from, MatrixColumn to);
+void copy_matrix_row(MatrixRow from, MatrixRow to);
+void set_matrix_column_to_colour(MatrixColumn matrix_column, PixelColour colour);
+void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour);
+
+#endif /* LEDMATRIX_H_ */
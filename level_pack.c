@@ -0,0 +1,80 @@
+/*
+ * level_pack.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+#include "level_pack.h"
+#include "maze.h"
+#include "bitboard.h"
+#include "line_drawing_characters.h"
+
+// Text output for each cell code (in the order of MAZE_CELL_CHARACTERS)
+static const char cell_text[NUM_MAZE_CODES][4] PROGMEM = {
+	" ",
+	".",
+	"P",	// power-pellet
+	LINE_HORIZONTAL,
+	LINE_VERTICAL,
+	LINE_DOWN_AND_RIGHT,
+	LINE_DOWN_AND_LEFT,
+	LINE_UP_AND_RIGHT,
+	LINE_UP_AND_LEFT,
+	LINE_VERTICAL_AND_RIGHT,
+	LINE_VERTICAL_AND_LEFT,
+	LINE_HORIZONTAL_AND_UP,
+	LINE_HORIZONTAL_AND_DOWN,
+	LINE_VERTICAL_AND_HORIZONTAL
+};
+
+void pack_reader_start(PackReader* reader, const uint8_t* stream) {
+	reader->next = stream;
+	reader->remaining = 0;
+}
+
+uint8_t pack_reader_next(PackReader* reader) {
+	if(reader->remaining == 0) {
+		uint8_t run = pgm_read_byte(reader->next++);
+		reader->code = run >> 4;
+		reader->remaining = (run & 0x0F) + 1;
+	}
+	reader->remaining--;
+	return reader->code;
+}
+
+uint8_t pack_code_at(const uint8_t* row, uint8_t x) {
+	for(;;) {
+		uint8_t run = pgm_read_byte(row++);
+		uint8_t length = (run & 0x0F) + 1;
+		if(x < length) {
+			return run >> 4;
+		}
+		x -= length;
+	}
+}
+
+uint8_t pack_decode_maze_row(PackReader* reader, uint8_t width, uint8_t* walls,
+		uint8_t* pacdots, uint8_t* power_pellets) {
+	uint8_t num_pacdots = 0;
+	for(uint8_t x = 0; x < width; x++) {
+		uint8_t code = pack_reader_next(reader);
+		if(code >= NUM_MAZE_CODES) {
+			// Shouldn't happen but we show an x in case it does
+			printf("%s", LINE_MISSING);
+			continue;
+		}
+		fputs_P(cell_text[code], stdout);
+		if(code >= MAZE_CODE_FIRST_WALL) {
+			bitboard_set(walls, x);
+		} else if(code == MAZE_CODE_PACDOT) {
+			bitboard_set(pacdots, x);
+			num_pacdots++;
+		} else if(code == MAZE_CODE_POWER_PELLET) {
+			bitboard_set(power_pellets, x);
+		}
+	}
+	printf("\n");
+	return num_pacdots;
+}
@@ -0,0 +1,40 @@
+/*
+ * level_pack.h
+ *
+ * Author: Joel Foster
+ *
+ * Decoding of the run length encoded streams in the level pack (see
+ * maze.h). Streams are read one cell at a time so no buffer is needed
+ * to unpack a level.
+ */
+
+#ifndef LEVEL_PACK_H_
+#define LEVEL_PACK_H_
+
+#include <stdint.h>
+
+// Position in a stream (in program memory)
+typedef struct {
+	const uint8_t* next;	// next byte of the stream
+	uint8_t code;			// code of the current run
+	uint8_t remaining;		// number of cells left in the current run
+} PackReader;
+
+// Start reading the stream at the given address
+void pack_reader_start(PackReader* reader, const uint8_t* stream);
+
+// Returns the code of the next cell in the stream
+uint8_t pack_reader_next(PackReader* reader);
+
+// Returns the code of cell x in the row of a stream that starts at row
+uint8_t pack_code_at(const uint8_t* row, uint8_t x);
+
+// Decode the next row (width cells) of a maze stream. The row is output to
+// the terminal (with line drawing characters for the walls) followed by a
+// new line. The bits for walls, pacdots and power pellets are set in the
+// given rows of bits (see bitboard.h) - the caller must clear them first.
+// Returns the number of pacdots in the row.
+uint8_t pack_decode_maze_row(PackReader* reader, uint8_t width, uint8_t* walls,
+		uint8_t* pacdots, uint8_t* power_pellets);
+
+#endif /* LEVEL_PACK_H_ */
@@ -1,32 +1,32 @@
-/*
- * line_drawing_characters.h
- *
- * Definitions of Unicode line drawing characters.
- *
- * Author: Peter Sutton
- */ 
-
-
-#ifndef LINE_DRAWING_CHARACTERS_H_
-#define LINE_DRAWING_CHARACTERS_H_
-
-// No line
-#define LINE_MISSING					"x"
-// Solid lines
-#define LINE_VERTICAL					"\u2502"
-#define LINE_HORIZONTAL					"\u2500"
-// Right angles
-#define LINE_DOWN_AND_RIGHT				"\u250C"
-#define LINE_DOWN_AND_LEFT				"\u2510"
-#define LINE_UP_AND_RIGHT				"\u2514"
-#define LINE_UP_AND_LEFT				"\u2518"
-// Straight through with line off it
-#define LINE_VERTICAL_AND_RIGHT				"\u251C"
-#define LINE_VERTICAL_AND_LEFT				"\u2524"
-#define LINE_HORIZONTAL_AND_UP				"\u2534"
-#define LINE_HORIZONTAL_AND_DOWN			"\u252C"
-// Cross
-#define LINE_VERTICAL_AND_HORIZONTAL			"\u253C"
-
-
-#endif /* LINE_DRAWING_CHARACTERS_H_ */
+/*
+ * line_drawing_characters.h
+ *
+ * Definitions of Unicode line drawing characters.
+ *
+ * Author: Peter Sutton
+ */ 
+
+
+#ifndef LINE_DRAWING_CHARACTERS_H_
+#define LINE_DRAWING_CHARACTERS_H_
+
+// No line
+#define LINE_MISSING					"x"
+// Solid lines
+#define LINE_VERTICAL					"\u2502"
+#define LINE_HORIZONTAL					"\u2500"
+// Right angles
+#define LINE_DOWN_AND_RIGHT				"\u250C"
+#define LINE_DOWN_AND_LEFT				"\u2510"
+#define LINE_UP_AND_RIGHT				"\u2514"
+#define LINE_UP_AND_LEFT				"\u2518"
+// Straight through with line off it
+#define LINE_VERTICAL_AND_RIGHT				"\u251C"
+#define LINE_VERTICAL_AND_LEFT				"\u2524"
+#define LINE_HORIZONTAL_AND_UP				"\u2534"
+#define LINE_HORIZONTAL_AND_DOWN			"\u252C"
+// Cross
+#define LINE_VERTICAL_AND_HORIZONTAL			"\u253C"
+
+
+#endif /* LINE_DRAWING_CHARACTERS_H_ */
@@ -0,0 +1,69 @@
+/*
+ * maze.h
+ *
+ * Author: Joel Foster
+ *
+ * Description of each level (maze) of the game. The levels themselves are
+ * in maze_tables.h, which is generated from the files in levels/ by the
+ * maze compiler (tools/mazec.c) - see there for the level file format.
+ * (This file is also used by the maze compiler.)
+ */
+
+#ifndef MAZE_H_
+#define MAZE_H_
+
+#include <stdint.h>
+
+// Level pack format
+// The maze for each level is a stream of bytes in program memory. Each byte
+// is a run of identical cells along a row - the high nibble is the code for
+// the cell (its position in MAZE_CELL_CHARACTERS) and the low nibble is the
+// length of the run minus 1 (so a byte covers 1 to MAZE_MAX_RUN cells).
+// Runs never continue from one row onto the next, so the maze can be
+// decoded a row at a time (see level_pack.h).
+// The characters are the ones used in the level files: space is empty,
+// . is a pacdot, P is a power pellet and the rest are walls.
+#define MAZE_CELL_CHARACTERS " .P-|F7LJ><^v+"
+#define MAZE_CODE_EMPTY 0
+#define MAZE_CODE_PACDOT 1
+#define MAZE_CODE_POWER_PELLET 2
+#define MAZE_CODE_FIRST_WALL 3	// this and higher codes are walls
+#define NUM_MAZE_CODES 14
+#define MAZE_MAX_RUN 16
+
+// The route home for eaten ghosts is stored in the same way, with each code
+// being the direction (DIRN_LEFT to DIRN_DOWN) to step in to get one cell
+// closer to the ghost home, FLOW_AT_HOME if the cell is part of the ghost
+// home, or FLOW_NO_ROUTE for walls and cells that can't reach it. Since the
+// eyes need to look up single cells, home_flow_rows gives the offset of the
+// first byte of each row.
+#define FLOW_AT_HOME 0x0E
+#define FLOW_NO_ROUTE 0x0F
+
+// Details of a level, stored in program memory (as are the streams).
+// The pac-man moves every pacman_move_period milliseconds. Each ghost's
+// time between moves (from its definition in game.c) is scaled to
+// ghost_period_percent percent. num_ghosts ghosts are in play (no more than
+// MAX_GHOSTS of them - see game.h).
+typedef struct {
+	uint8_t width;
+	uint8_t height;
+	uint8_t pacman_x;
+	uint8_t pacman_y;
+	uint8_t pacman_direction;
+	uint8_t ghost_home_x_left;
+	uint8_t ghost_home_x_right;
+	uint8_t ghost_home_y;
+	uint8_t ghost_home_entry_x_left;
+	uint8_t ghost_home_entry_x_right;
+	uint8_t ghost_home_entry_y;
+	uint16_t pacman_move_period;
+	uint8_t ghost_period_percent;
+	uint8_t num_ghosts;
+	uint16_t num_pacdots;
+	const uint8_t* maze;
+	const uint8_t* home_flow;
+	const uint16_t* home_flow_rows;
+} LevelData;
+
+#endif /* MAZE_H_ */
@@ -0,0 +1,221 @@
+/*
+ * maze_tables.h
+ *
+ * Generated by tools/mazec.c from the files in levels/ - do not edit.
+ * See maze.h for a description of the level pack.
+ */
+
+#ifndef MAZE_TABLES_H_
+#define MAZE_TABLES_H_
+
+#include <avr/pgmspace.h>
+#include "maze.h"
+
+// Level 0 - from levels/01_original.txt
+static const uint8_t level_0_maze[] PROGMEM = {
+	0x50, 0x3C, 0xC0, 0x30, 0xC0, 0x3C, 0x60,
+	0x40, 0x1C, 0x40, 0x00, 0x40, 0x1C, 0x40,
+	0x40, 0x10, 0x50, 0x32, 0x60, 0x10, 0x50, 0x32, 0x60, 0x10, 0x40, 0x00, 0x40, 0x10, 0x50, 0x32, 0x60, 0x10, 0x50, 0x32, 0x60, 0x10, 0x40,
+	0x40, 0x10, 0x40, 0x02, 0x40, 0x10, 0x70, 0x32, 0x80, 0x10, 0x70, 0x30, 0x80, 0x10, 0x70, 0x32, 0x80, 0x10, 0x40, 0x02, 0x40, 0x10, 0x40,
+	0x40, 0x10, 0x40, 0x02, 0x40, 0x1F, 0x10, 0x40, 0x02, 0x40, 0x10, 0x40,
+	0x40, 0x10, 0x40, 0x02, 0x40, 0x10, 0x50, 0x32, 0x60, 0x10, 0x50, 0x30, 0x60, 0x10, 0x50, 0x32, 0x60, 0x10, 0x40, 0x02, 0x40, 0x10, 0x40,
+	0x40, 0x20, 0x70, 0x32, 0x80, 0x10, 0x70, 0x32, 0x80, 0x10, 0x70, 0x30, 0x80, 0x10, 0x70, 0x32, 0x80, 0x10, 0x70, 0x32, 0x80, 0x20, 0x40,
+	0x40, 0x1F, 0x1C, 0x40,
+	0x40, 0x10, 0x50, 0x32, 0x60, 0x10, 0x50, 0x60, 0x10, 0x50, 0x36, 0x60, 0x10, 0x50, 0x60, 0x10, 0x50, 0x32, 0x60, 0x10, 0x40,
+	0x40, 0x10, 0x70, 0x32, 0x80, 0x10, 0x41, 0x10, 0x70, 0x31, 0x60, 0x00, 0x50, 0x31, 0x80, 0x10, 0x41, 0x10, 0x70, 0x32, 0x80, 0x10, 0x40,
+	0x40, 0x16, 0x41, 0x13, 0x40, 0x00, 0x40, 0x13, 0x41, 0x16, 0x40,
+	0x70, 0x34, 0x60, 0x10, 0x40, 0x70, 0x31, 0x60, 0x00, 0x40, 0x00, 0x40, 0x00, 0x50, 0x31, 0x80, 0x40, 0x10, 0x50, 0x34, 0x80,
+	0x05, 0x40, 0x10, 0x40, 0x50, 0x31, 0x80, 0x00, 0x70, 0x30, 0x80, 0x00, 0x70, 0x31, 0x60, 0x40, 0x10, 0x40, 0x05,
+	0x05, 0x40, 0x10, 0x41, 0x0A, 0x41, 0x10, 0x40, 0x05,
+	0x35, 0x80, 0x10, 0x70, 0x80, 0x00, 0x50, 0x31, 0x02, 0x31, 0x60, 0x00, 0x70, 0x80, 0x10, 0x70, 0x35,
+	0x06, 0x10, 0x02, 0x40, 0x06, 0x40, 0x02, 0x10, 0x06,
+	0x35, 0x60, 0x10, 0x50, 0x60, 0x00, 0x70, 0x36, 0x80, 0x00, 0x50, 0x60, 0x10, 0x50, 0x35,
+	0x05, 0x40, 0x10, 0x41, 0x0A, 0x41, 0x10, 0x40, 0x05,
+	0x05, 0x40, 0x10, 0x41, 0x00, 0x50, 0x36, 0x60, 0x00, 0x41, 0x10, 0x40, 0x05,
+	0x50, 0x34, 0x80, 0x10, 0x70, 0x80, 0x00, 0x70, 0x31, 0x60, 0x00, 0x50, 0x31, 0x80, 0x00, 0x70, 0x80, 0x10, 0x70, 0x34, 0x60,
+	0x40, 0x1C, 0x40, 0x00, 0x40, 0x1C, 0x40,
+	0x40, 0x10, 0x50, 0x32, 0x60, 0x10, 0x50, 0x32, 0x60, 0x10, 0x40, 0x00, 0x40, 0x10, 0x50, 0x32, 0x60, 0x10, 0x50, 0x32, 0x60, 0x10, 0x40,
+	0x40, 0x10, 0x70, 0x30, 0x60, 0x00, 0x40, 0x10, 0x70, 0x32, 0x80, 0x10, 0x70, 0x30, 0x80, 0x10, 0x70, 0x32, 0x80, 0x10, 0x40, 0x00, 0x50, 0x30, 0x80, 0x10, 0x40,
+	0x40, 0x20, 0x11, 0x40, 0x00, 0x40, 0x17, 0x00, 0x17, 0x40, 0x00, 0x40, 0x11, 0x20, 0x40,
+	0x90, 0x30, 0x60, 0x10, 0x40, 0x00, 0x40, 0x10, 0x50, 0x60, 0x10, 0x50, 0x36, 0x60, 0x10, 0x50, 0x60, 0x10, 0x40, 0x00, 0x40, 0x10, 0x50, 0x30, 0xA0,
+	0x90, 0x30, 0x80, 0x10, 0x70, 0x30, 0x80, 0x10, 0x41, 0x10, 0x70, 0x31, 0x60, 0x00, 0x50, 0x31, 0x80, 0x10, 0x41, 0x10, 0x70, 0x30, 0x80, 0x10, 0x70, 0x30, 0xA0,
+	0x40, 0x16, 0x41, 0x13, 0x40, 0x00, 0x40, 0x13, 0x41, 0x16, 0x40,
+	0x40, 0x10, 0x50, 0x34, 0x80, 0x70, 0x31, 0x60, 0x10, 0x40, 0x00, 0x40, 0x10, 0x50, 0x31, 0x80, 0x70, 0x34, 0x60, 0x10, 0x40,
+	0x40, 0x10, 0x70, 0x38, 0x80, 0x10, 0x70, 0x30, 0x80, 0x10, 0x70, 0x38, 0x80, 0x10, 0x40,
+	0x40, 0x1F, 0x1C, 0x40,
+	0x70, 0x3F, 0x3C, 0x80,
+};
+
+static const uint8_t level_0_home_flow[] PROGMEM = {
+	0xFF, 0xFE,
+	0xF0, 0x25, 0x30, 0x01, 0x22, 0x30, 0xF2, 0x30, 0x01, 0x22, 0x30, 0x04, 0x30, 0xF0,
+	0xF0, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF0,
+	0xF0, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF0,
+	0xF0, 0x30, 0xF4, 0x30, 0x01, 0x22, 0x30, 0x01, 0x20, 0x30, 0x01, 0x22, 0x30, 0xF4, 0x30, 0xF0,
+	0xF0, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF0,
+	0xF0, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF4, 0x30, 0xF0,
+	0xF0, 0x28, 0x30, 0x04, 0x23, 0x30, 0x08, 0xF0,
+	0xF0, 0x10, 0xF4, 0x10, 0xF1, 0x30, 0xF8, 0x30, 0xF1, 0x10, 0xF4, 0x10, 0xF0,
+	0xF0, 0x10, 0xF4, 0x10, 0xF1, 0x30, 0xF8, 0x30, 0xF1, 0x30, 0xF4, 0x30, 0xF0,
+	0xF0, 0x25, 0x30, 0xF1, 0x22, 0x30, 0xF2, 0x30, 0x02, 0xF1, 0x30, 0x05, 0xF0,
+	0xF6, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF6,
+	0xF6, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF6,
+	0xF6, 0x30, 0xF1, 0x23, 0x32, 0x03, 0xF1, 0x30, 0xF6,
+	0xF6, 0x30, 0xF1, 0x10, 0xF2, 0x32, 0xF2, 0x10, 0xF1, 0x30, 0xF6,
+	0x29, 0x10, 0xF0, 0xE6, 0xF0, 0x10, 0x09,
+	0xF6, 0x10, 0xF1, 0x10, 0xF8, 0x10, 0xF1, 0x10, 0xF6,
+	0xF6, 0x10, 0xF1, 0x10, 0x04, 0x23, 0x10, 0xF1, 0x10, 0xF6,
+	0xF6, 0x10, 0xF1, 0x10, 0xF8, 0x10, 0xF1, 0x10, 0xF6,
+	0xF6, 0x10, 0xF1, 0x10, 0xF8, 0x10, 0xF1, 0x10, 0xF6,
+	0xF0, 0x28, 0x10, 0x02, 0xF2, 0x22, 0x10, 0x08, 0xF0,
+	0xF0, 0x10, 0xF4, 0x10, 0xF4, 0x10, 0xF2, 0x10, 0xF4, 0x10, 0xF4, 0x10, 0xF0,
+	0xF0, 0x10, 0xF4, 0x10, 0xF4, 0x10, 0xF2, 0x10, 0xF4, 0x10, 0xF4, 0x10, 0xF0,
+	0xF0, 0x10, 0x01, 0xF2, 0x10, 0x01, 0x22, 0x10, 0x01, 0x20, 0x10, 0x01, 0x22, 0x10, 0xF2, 0x21, 0x10, 0xF0,
+	0xF2, 0x30, 0xF2, 0x10, 0xF1, 0x10, 0xF8, 0x10, 0xF1, 0x10, 0xF2, 0x30, 0xF2,
+	0xF2, 0x30, 0xF2, 0x10, 0xF1, 0x10, 0xF8, 0x10, 0xF1, 0x10, 0xF2, 0x30, 0xF2,
+	0xF0, 0x25, 0x10, 0xF1, 0x10, 0x02, 0xF2, 0x22, 0x10, 0xF1, 0x10, 0x05, 0xF0,
+	0xF0, 0x10, 0xFA, 0x10, 0xF2, 0x10, 0xFA, 0x10, 0xF0,
+	0xF0, 0x10, 0xFA, 0x10, 0xF2, 0x10, 0xFA, 0x10, 0xF0,
+	0xF0, 0x10, 0x04, 0x25, 0x10, 0x01, 0x20, 0x10, 0x04, 0x25, 0x10, 0xF0,
+	0xFF, 0xFE,
+};
+
+static const uint16_t level_0_home_flow_rows[31] PROGMEM = {
+	0, 2, 16, 29, 42, 58, 71, 84, 92, 105, 118, 131, 140, 149, 158, 169,
+	176, 185, 195, 204, 213, 222, 235, 248, 266, 279, 292, 305, 314, 323, 335,
+};
+
+// Level 1 - from levels/02_box.txt
+static const uint8_t level_1_maze[] PROGMEM = {
+	0x50, 0x3A, 0xC0, 0x3A, 0x60,
+	0x40, 0x20, 0x19, 0x40, 0x19, 0x20, 0x40,
+	0x40, 0x10, 0x32, 0x10, 0x33, 0x11, 0x40, 0x11, 0x33, 0x10, 0x32, 0x10, 0x40,
+	0x40, 0x1F, 0x16, 0x40,
+	0x40, 0x10, 0x32, 0x10, 0x40, 0x10, 0x38, 0x10, 0x40, 0x10, 0x32, 0x10, 0x40,
+	0x40, 0x14, 0x40, 0x1A, 0x40, 0x14, 0x40,
+	0x70, 0x32, 0x60, 0x10, 0x90, 0x31, 0x10, 0x34, 0x10, 0x31, 0xA0, 0x10, 0x50, 0x32, 0x80,
+	0x03, 0x40, 0x10, 0x40, 0x1A, 0x40, 0x10, 0x40, 0x03,
+	0x33, 0x80, 0x10, 0x40, 0x10, 0x50, 0x32, 0x00, 0x32, 0x60, 0x10, 0x40, 0x10, 0x70, 0x33,
+	0x04, 0x12, 0x40, 0x06, 0x40, 0x12, 0x04,
+	0x33, 0x60, 0x10, 0x40, 0x10, 0x70, 0x36, 0x80, 0x10, 0x40, 0x10, 0x50, 0x33,
+	0x03, 0x40, 0x10, 0x40, 0x1A, 0x40, 0x10, 0x40, 0x03,
+	0x50, 0x32, 0x80, 0x10, 0x40, 0x10, 0x33, 0xC0, 0x33, 0x10, 0x40, 0x10, 0x70, 0x32, 0x60,
+	0x40, 0x14, 0x40, 0x14, 0x40, 0x14, 0x40, 0x14, 0x40,
+	0x40, 0x10, 0x31, 0x60, 0x10, 0x40, 0x10, 0x32, 0x12, 0x32, 0x10, 0x40, 0x10, 0x50, 0x31, 0x10, 0x40,
+	0x40, 0x20, 0x11, 0x40, 0x1E, 0x40, 0x11, 0x20, 0x40,
+	0x90, 0x31, 0x10, 0x40, 0x10, 0x31, 0xC0, 0x30, 0x10, 0x32, 0x10, 0x30, 0xC0, 0x31, 0x10, 0x40, 0x10, 0x31, 0xA0,
+	0x40, 0x16, 0x40, 0x16, 0x40, 0x16, 0x40,
+	0x40, 0x10, 0x34, 0x10, 0x40, 0x10, 0x34, 0x10, 0x40, 0x10, 0x34, 0x10, 0x40,
+	0x40, 0x1A, 0x00, 0x1A, 0x40,
+	0x70, 0x3F, 0x36, 0x80,
+};
+
+static const uint8_t level_1_home_flow[] PROGMEM = {
+	0xFF, 0xF8,
+	0xF0, 0x23, 0x30, 0x01, 0x21, 0x31, 0xF0, 0x20, 0x30, 0x00, 0x22, 0x30, 0x02, 0x30, 0xF0,
+	0xF0, 0x30, 0xF2, 0x30, 0xF3, 0x31, 0xF0, 0x20, 0x30, 0xF3, 0x30, 0xF2, 0x30, 0xF0,
+	0xF0, 0x25, 0x30, 0x03, 0x24, 0x30, 0x05, 0xF0,
+	0xF0, 0x10, 0xF2, 0x10, 0xF0, 0x30, 0xF8, 0x30, 0xF0, 0x10, 0xF2, 0x10, 0xF0,
+	0xF0, 0x23, 0x10, 0xF0, 0x21, 0x30, 0x01, 0x22, 0x30, 0x01, 0xF0, 0x30, 0x03, 0xF0,
+	0xF4, 0x30, 0xF2, 0x30, 0xF4, 0x30, 0xF2, 0x30, 0xF4,
+	0xF4, 0x30, 0xF0, 0x24, 0x30, 0x04, 0xF0, 0x30, 0xF4,
+	0xF4, 0x30, 0xF0, 0x10, 0xF3, 0x30, 0xF3, 0x10, 0xF0, 0x30, 0xF4,
+	0x26, 0x10, 0xF0, 0xE6, 0xF0, 0x10, 0x06,
+	0xF4, 0x10, 0xF0, 0x10, 0xF8, 0x10, 0xF0, 0x10, 0xF4,
+	0xF4, 0x10, 0xF0, 0x10, 0x03, 0x24, 0x10, 0xF0, 0x10, 0xF4,
+	0xF4, 0x10, 0xF0, 0x10, 0xF8, 0x10, 0xF0, 0x10, 0xF4,
+	0xF0, 0x23, 0x10, 0xF0, 0x10, 0x03, 0xF0, 0x23, 0x10, 0xF0, 0x10, 0x03, 0xF0,
+	0xF0, 0x10, 0xF2, 0x10, 0xF0, 0x10, 0xF2, 0x10, 0x20, 0x10, 0xF2, 0x10, 0xF0, 0x10, 0xF2, 0x10, 0xF0,
+	0xF0, 0x10, 0x00, 0x30, 0xF0, 0x21, 0x10, 0x03, 0x24, 0x10, 0x01, 0xF0, 0x30, 0x20, 0x10, 0xF0,
+	0xF2, 0x30, 0xF0, 0x10, 0xF3, 0x10, 0xF2, 0x10, 0xF3, 0x10, 0xF0, 0x30, 0xF2,
+	0xF0, 0x23, 0x10, 0x01, 0xF0, 0x20, 0x10, 0x00, 0x21, 0x10, 0x00, 0xF0, 0x21, 0x10, 0x03, 0xF0,
+	0xF0, 0x10, 0xF4, 0x10, 0xF0, 0x10, 0xF4, 0x10, 0xF0, 0x10, 0xF4, 0x10, 0xF0,
+	0xF0, 0x10, 0x00, 0x23, 0x10, 0x20, 0x10, 0x01, 0x22, 0x10, 0x20, 0x10, 0x02, 0x21, 0x10, 0xF0,
+	0xFF, 0xF8,
+};
+
+static const uint16_t level_1_home_flow_rows[21] PROGMEM = {
+	0, 2, 17, 31, 39, 52, 66, 75, 84, 95, 102, 111, 121, 130, 143, 160,
+	176, 189, 205, 218, 234,
+};
+
+// Level 2 - from levels/03_mini.txt
+static const uint8_t level_2_maze[] PROGMEM = {
+	0x50, 0x38, 0xC0, 0x38, 0x60,
+	0x40, 0x20, 0x17, 0x40, 0x17, 0x20, 0x40,
+	0x40, 0x10, 0x31, 0x10, 0x32, 0x14, 0x32, 0x10, 0x31, 0x10, 0x40,
+	0x40, 0x1F, 0x12, 0x40,
+	0x40, 0x10, 0x31, 0x10, 0x40, 0x10, 0x50, 0x31, 0x00, 0x31, 0x60, 0x10, 0x40, 0x10, 0x31, 0x10, 0x40,
+	0x40, 0x13, 0x40, 0x10, 0x40, 0x04, 0x40, 0x10, 0x40, 0x13, 0x40,
+	0x40, 0x10, 0x31, 0x10, 0x40, 0x10, 0x70, 0x34, 0x80, 0x10, 0x40, 0x10, 0x31, 0x10, 0x40,
+	0x40, 0x20, 0x17, 0x00, 0x17, 0x20, 0x40,
+	0x40, 0x10, 0x32, 0x10, 0x50, 0x31, 0x10, 0x30, 0x10, 0x31, 0x60, 0x10, 0x32, 0x10, 0x40,
+	0x40, 0x14, 0x40, 0x16, 0x40, 0x14, 0x40,
+	0x40, 0x12, 0x40, 0x12, 0x40, 0x12, 0x40, 0x12, 0x40, 0x12, 0x40,
+	0x70, 0x32, 0xB0, 0x32, 0xB0, 0x32, 0xB0, 0x32, 0xB0, 0x32, 0x80,
+};
+
+static const uint8_t level_2_home_flow[] PROGMEM = {
+	0xFF, 0xF4,
+	0xF0, 0x27, 0x30, 0xF0, 0x31, 0x02, 0x30, 0x01, 0x30, 0xF0,
+	0xF0, 0x30, 0xF1, 0x30, 0xF2, 0x21, 0x32, 0xF2, 0x30, 0xF1, 0x30, 0xF0,
+	0xF0, 0x28, 0x30, 0x08, 0xF0,
+	0xF0, 0x10, 0xF1, 0x10, 0xF0, 0x10, 0xF2, 0x30, 0xF2, 0x10, 0xF0, 0x10, 0xF1, 0x10, 0xF0,
+	0xF0, 0x22, 0x10, 0xF0, 0x10, 0xF0, 0xE4, 0xF0, 0x10, 0xF0, 0x10, 0x02, 0xF0,
+	0xF0, 0x10, 0xF1, 0x10, 0xF0, 0x10, 0xF6, 0x10, 0xF0, 0x10, 0xF1, 0x10, 0xF0,
+	0xF0, 0x24, 0x10, 0x02, 0x23, 0x10, 0x04, 0xF0,
+	0xF0, 0x10, 0xF2, 0x10, 0xF2, 0x10, 0xF0, 0x10, 0xF2, 0x10, 0xF2, 0x10, 0xF0,
+	0xF0, 0x23, 0x10, 0xF0, 0x21, 0x10, 0x20, 0x10, 0x00, 0x30, 0xF0, 0x10, 0x03, 0xF0,
+	0xF0, 0x21, 0x10, 0xF0, 0x10, 0x01, 0xF0, 0x10, 0x20, 0x10, 0xF0, 0x21, 0x10, 0xF0, 0x10, 0x01, 0xF0,
+	0xFF, 0xF4,
+};
+
+static const uint16_t level_2_home_flow_rows[12] PROGMEM = {
+	0, 2, 12, 24, 29, 44, 57, 70, 78, 91, 105, 122,
+};
+
+#define NUM_LEVELS 3
+#define LEVELS_MAX_WIDTH 31
+#define LEVELS_MAX_HEIGHT 31
+#define LEVELS_MAX_DOT_CELLS 281
+
+static const LevelData levels[NUM_LEVELS] PROGMEM = {
+	{	// Level 0 (489 + 337 bytes)
+		.width = 31, .height = 31,
+		.pacman_x = 15, .pacman_y = 23, .pacman_direction = DIRN_RIGHT,
+		.ghost_home_x_left = 12, .ghost_home_x_right = 18, .ghost_home_y = 15,
+		.ghost_home_entry_x_left = 14, .ghost_home_entry_x_right = 16, .ghost_home_entry_y = 14,
+		.pacman_move_period = 400, .ghost_period_percent = 100,
+		.num_ghosts = 4,
+		.num_pacdots = 277,
+		.maze = level_0_maze,
+		.home_flow = level_0_home_flow,
+		.home_flow_rows = level_0_home_flow_rows,
+	},
+	{	// Level 1 (215 + 236 bytes)
+		.width = 25, .height = 21,
+		.pacman_x = 12, .pacman_y = 19, .pacman_direction = DIRN_RIGHT,
+		.ghost_home_x_left = 9, .ghost_home_x_right = 15, .ghost_home_y = 9,
+		.ghost_home_entry_x_left = 12, .ghost_home_entry_x_right = 12, .ghost_home_entry_y = 8,
+		.pacman_move_period = 350, .ghost_period_percent = 90,
+		.num_ghosts = 5,
+		.num_pacdots = 229,
+		.maze = level_1_maze,
+		.home_flow = level_1_home_flow,
+		.home_flow_rows = level_1_home_flow_rows,
+	},
+	{	// Level 2 (121 + 124 bytes)
+		.width = 21, .height = 12,
+		.pacman_x = 10, .pacman_y = 7, .pacman_direction = DIRN_RIGHT,
+		.ghost_home_x_left = 8, .ghost_home_x_right = 12, .ghost_home_y = 5,
+		.ghost_home_entry_x_left = 10, .ghost_home_entry_x_right = 10, .ghost_home_entry_y = 4,
+		.pacman_move_period = 300, .ghost_period_percent = 80,
+		.num_ghosts = 6,
+		.num_pacdots = 120,
+		.maze = level_2_maze,
+		.home_flow = level_2_home_flow,
+		.home_flow_rows = level_2_home_flow_rows,
+	},
+};
+
+#endif /* MAZE_TABLES_H_ */
@@ -0,0 +1,255 @@
+/*
+ * maze_view.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "maze_view.h"
+#include "ledmatrix.h"
+#include "game.h"
+
+// Colours of the cells on the LED matrix
+#define WALL_COLOUR COLOUR_LIGHT_GREEN
+#define PACDOT_COLOUR COLOUR_LIGHT_YELLOW
+#define POWER_PELLET_COLOUR COLOUR_ORANGE
+#define PACMAN_COLOUR COLOUR_YELLOW
+#define GHOST_COLOUR COLOUR_RED
+#define FRIGHTENED_GHOST_COLOUR COLOUR_GREEN
+// Colours of a block of the map with up to a few pac-dots, and more
+#define FEW_PACDOTS_COLOUR COLOUR_LIGHT_ORANGE
+#define MANY_PACDOTS_COLOUR COLOUR_LIGHT_YELLOW
+#define FEW_PACDOTS ((MAP_BLOCK_WIDTH * MAP_BLOCK_HEIGHT) / 2)
+
+#if (MAX_FIELD_WIDTH + MAP_BLOCK_WIDTH - 1) / MAP_BLOCK_WIDTH > MATRIX_NUM_COLUMNS \
+		|| (MAX_FIELD_HEIGHT + MAP_BLOCK_HEIGHT - 1) / MAP_BLOCK_HEIGHT > MATRIX_NUM_ROWS
+#error "The map of the largest field doesn't fit on the LED matrix"
+#endif
+
+// Position of the pac-man in the window (if the window isn't against an
+// edge of the field)
+#define PACMAN_COLUMN (MATRIX_NUM_COLUMNS / 2)
+#define PACMAN_ROW (MATRIX_NUM_ROWS / 2)
+
+static uint8_t showing;
+static uint8_t mode;
+
+// The cell shown at the top left of the window
+static uint8_t view_x;
+static uint8_t view_y;
+
+// The cells (or blocks of the map) that have changed since they were last
+// drawn - bit x of changed[y] for the pixel at column x and row y of the
+// window or map (row 0 is the top). If redraw_all is set everything is
+// drawn again instead.
+static uint16_t changed[MATRIX_NUM_ROWS];
+static uint8_t redraw_all;
+
+// Returns the first cell of a window of window_size cells centred (as far
+// as the edges allow) on the given cell
+static uint8_t window_start(uint8_t centre, uint8_t centre_offset,
+		uint8_t field_size, uint8_t window_size) {
+	if(field_size <= window_size || centre <= centre_offset) {
+		return 0;
+	}
+	if(centre - centre_offset > field_size - window_size) {
+		return field_size - window_size;
+	}
+	return centre - centre_offset;
+}
+
+// Returns the colour shown for the cell at (x,y) of the field
+static PixelColour cell_colour(const GameState* state, uint8_t x, uint8_t y) {
+	if(x >= field_width || y >= field_height) {
+		return COLOUR_BLACK;
+	}
+	int8_t cell_contents = what_is_at(x, y);
+	if(cell_contents >= 0) {
+		if(state->ghost_state[cell_contents] == GHOST_STATE_FRIGHTENED) {
+			return FRIGHTENED_GHOST_COLOUR;
+		}
+		return GHOST_COLOUR;
+	}
+	switch(cell_contents) {
+		case CELL_CONTAINS_PACMAN:
+			return PACMAN_COLOUR;
+		case CELL_CONTAINS_PACDOT:
+			return PACDOT_COLOUR;
+		case CELL_CONTAINS_POWER_PELLET:
+			return POWER_PELLET_COLOUR;
+		case CELL_IS_WALL:
+			return WALL_COLOUR;
+		default:
+			return COLOUR_BLACK;
+	}
+}
+
+// Draw the cell at column x and row y of the window (row 0 is the top, the
+// bottom row of the LED matrix is its row 0)
+static void draw_cell(const GameState* state, uint8_t x, uint8_t y) {
+	ledmatrix_set_pixel(x, MATRIX_NUM_ROWS - 1 - y,
+			cell_colour(state, view_x + x, view_y + y));
+}
+
+static void draw_column(const GameState* state, uint8_t x) {
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		draw_cell(state, x, y);
+	}
+}
+
+static void draw_row(const GameState* state, uint8_t y) {
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		draw_cell(state, x, y);
+	}
+}
+
+// Draw the block of the map at column x and row y (row 0 is the top) - in
+// order of priority the pac-man, a ghost, a power pellet, the pac-dots
+// left, a wall or nothing
+static void draw_block(const GameState* state, uint8_t x, uint8_t y) {
+	PixelColour colour = COLOUR_BLACK;
+	uint8_t pacdots = 0;
+	uint8_t power_pellet = 0;
+	uint8_t wall = 0;
+	for(uint8_t cell_y = y * MAP_BLOCK_HEIGHT; cell_y < (y + 1) * MAP_BLOCK_HEIGHT; cell_y++) {
+		for(uint8_t cell_x = x * MAP_BLOCK_WIDTH; cell_x < (x + 1) * MAP_BLOCK_WIDTH; cell_x++) {
+			if(cell_x >= field_width || cell_y >= field_height) {
+				continue;
+			}
+			int8_t cell_contents = what_is_at(cell_x, cell_y);
+			if(cell_contents == CELL_CONTAINS_PACMAN) {
+				ledmatrix_set_pixel(x, MATRIX_NUM_ROWS - 1 - y, PACMAN_COLOUR);
+				return;
+			} else if(cell_contents >= 0) {
+				colour = cell_colour(state, cell_x, cell_y);
+			} else if(cell_contents == CELL_CONTAINS_POWER_PELLET) {
+				power_pellet = 1;
+			} else if(cell_contents == CELL_CONTAINS_PACDOT) {
+				pacdots++;
+			} else if(cell_contents == CELL_IS_WALL) {
+				wall = 1;
+			}
+		}
+	}
+	if(colour != COLOUR_BLACK) {
+		// A ghost
+	} else if(power_pellet) {
+		colour = POWER_PELLET_COLOUR;
+	} else if(pacdots) {
+		colour = (pacdots <= FEW_PACDOTS) ? FEW_PACDOTS_COLOUR : MANY_PACDOTS_COLOUR;
+	} else if(wall) {
+		colour = WALL_COLOUR;
+	}
+	ledmatrix_set_pixel(x, MATRIX_NUM_ROWS - 1 - y, colour);
+}
+
+// Bring the map up to date
+static void update_map(const GameState* state) {
+	for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+		if(redraw_all) {
+			changed[y] = 0xFFFF;
+		}
+		for(uint8_t x = 0; changed[y]; x++) {
+			if(changed[y] & (1<<x)) {
+				draw_block(state, x, y);
+				changed[y] &= ~(1<<x);
+			}
+		}
+	}
+	redraw_all = 0;
+}
+
+void maze_view_start(void) {
+	showing = 1;
+	redraw_all = 1;
+}
+
+void maze_view_toggle_mode(void) {
+	mode = (mode == MAZE_VIEW_WINDOW) ? MAZE_VIEW_MAP : MAZE_VIEW_WINDOW;
+	redraw_all = 1;
+}
+
+void maze_view_stop(void) {
+	showing = 0;
+}
+
+void maze_view_update(void) {
+	if(!showing) {
+		return;
+	}
+	const GameState* state = get_game_state();
+	if(mode == MAZE_VIEW_MAP) {
+		update_map(state);
+		ledmatrix_flush();
+		return;
+	}
+	uint8_t new_x = window_start(state->pacman_x, PACMAN_COLUMN, field_width,
+			MATRIX_NUM_COLUMNS);
+	uint8_t new_y = window_start(state->pacman_y, PACMAN_ROW, field_height,
+			MATRIX_NUM_ROWS);
+	if(!redraw_all) {
+		// The cells that have changed are drawn where they are now, then
+		// the display is shifted if the window has moved by one cell
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			for(uint8_t x = 0; changed[y]; x++) {
+				if(changed[y] & (1<<x)) {
+					draw_cell(state, x, y);
+					changed[y] &= ~(1<<x);
+				}
+			}
+		}
+		if(new_x == view_x + 1) {
+			ledmatrix_shift_frame(LEDMATRIX_SHIFT_LEFT);
+			view_x = new_x;
+			draw_column(state, MATRIX_NUM_COLUMNS - 1);
+		} else if(new_x + 1 == view_x) {
+			ledmatrix_shift_frame(LEDMATRIX_SHIFT_RIGHT);
+			view_x = new_x;
+			draw_column(state, 0);
+		} else if(new_x != view_x) {
+			redraw_all = 1;
+		}
+		// (The top of the window is the top of the LED matrix)
+		if(new_y == view_y + 1) {
+			ledmatrix_shift_frame(LEDMATRIX_SHIFT_UP);
+			view_y = new_y;
+			draw_row(state, MATRIX_NUM_ROWS - 1);
+		} else if(new_y + 1 == view_y) {
+			ledmatrix_shift_frame(LEDMATRIX_SHIFT_DOWN);
+			view_y = new_y;
+			draw_row(state, 0);
+		} else if(new_y != view_y) {
+			redraw_all = 1;
+		}
+	}
+	if(redraw_all) {
+		// Only the pixels that differ are sent
+		view_x = new_x;
+		view_y = new_y;
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			draw_row(state, y);
+		}
+		memset(changed, 0, sizeof(changed));
+		redraw_all = 0;
+	}
+	ledmatrix_flush();
+}
+
+void maze_view_cell_changed(uint8_t x, uint8_t y) {
+	if(mode == MAZE_VIEW_MAP) {
+		changed[y / MAP_BLOCK_HEIGHT] |= (1<<(x / MAP_BLOCK_WIDTH));
+		return;
+	}
+	// (Cells to the left of or above the window wrap around to large
+	// numbers)
+	uint8_t column = x - view_x;
+	uint8_t row = y - view_y;
+	if(column < MATRIX_NUM_COLUMNS && row < MATRIX_NUM_ROWS) {
+		changed[row] |= (1<<column);
+	}
+}
+
+void maze_view_field_changed(void) {
+	redraw_all = 1;
+}
@@ -0,0 +1,54 @@
+/*
+ * maze_view.h
+ *
+ * Author: Joel Foster
+ *
+ * Shows part of the maze on the LED matrix while the game is played - a
+ * window the size of the matrix centred on the pac-man (as far as the edges
+ * of the field allow) showing the walls, pac-dots, power pellets, pac-man
+ * and ghosts. The view is drawn into the LED matrix frame buffer (see
+ * ledmatrix.h) so only the pixels that change are sent, and when the window
+ * moves by a cell the display is shifted and just the new column or row
+ * is drawn.
+ *
+ * Alternatively the whole field can be shown at once as a map - each pixel
+ * is a block of MAP_BLOCK_WIDTH by MAP_BLOCK_HEIGHT cells, showing the
+ * pac-man or a ghost if one is in the block, otherwise how many pac-dots
+ * are left in it (or a power pellet, or a wall).
+ *
+ * The game tells us which cells it has drawn on the terminal (i.e. which
+ * have changed) and just those cells (or blocks) are drawn again on the
+ * next maze_view_update().
+ */
+
+#ifndef MAZE_VIEW_H_
+#define MAZE_VIEW_H_
+
+#include <stdint.h>
+
+// What is shown
+#define MAZE_VIEW_WINDOW 0
+#define MAZE_VIEW_MAP 1
+
+// Size of the block of cells shown by each pixel of the map
+#define MAP_BLOCK_WIDTH 2
+#define MAP_BLOCK_HEIGHT 4
+
+// Start showing the maze on the LED matrix (all of it is drawn again), or
+// stop (the LED matrix is left as it is)
+void maze_view_start(void);
+void maze_view_stop(void);
+
+// Change between the window and the map (the window is shown to start with)
+void maze_view_toggle_mode(void);
+
+// Bring the LED matrix up to date with the game - called once each time
+// through the game loop
+void maze_view_update(void);
+
+// Called by the game when the cell at (x,y) has changed, or when the whole
+// field has (e.g. a new level)
+void maze_view_cell_changed(uint8_t x, uint8_t y);
+void maze_view_field_changed(void);
+
+#endif /* MAZE_VIEW_H_ */
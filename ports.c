@@ -0,0 +1,89 @@
+/*
+ * ports.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "ports.h"
+
+#define NUM_PORTS 4
+
+// The value last written to each port's output register, and the pins of
+// each port that have been claimed (or reserved)
+static uint8_t shadow[NUM_PORTS];
+static uint8_t claimed[NUM_PORTS];
+
+// Returns the output register of a port
+static volatile uint8_t* port_register(uint8_t port) {
+	switch(port) {
+		case IO_PORT_A:
+			return &PORTA;
+		case IO_PORT_B:
+			return &PORTB;
+		case IO_PORT_C:
+			return &PORTC;
+		default:
+			return &PORTD;
+	}
+}
+
+// Returns the data direction register of a port
+static volatile uint8_t* ddr_register(uint8_t port) {
+	switch(port) {
+		case IO_PORT_A:
+			return &DDRA;
+		case IO_PORT_B:
+			return &DDRB;
+		case IO_PORT_C:
+			return &DDRC;
+		default:
+			return &DDRD;
+	}
+}
+
+// Take the given pins of a port (and make them outputs if make_outputs is
+// 1). Returns 1 if successful, 0 if any of them are already taken.
+static uint8_t take_pins(uint8_t port, uint8_t pins, uint8_t make_outputs) {
+	if(port >= NUM_PORTS || (claimed[port] & pins)) {
+		return 0;
+	}
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if(!claimed[port]) {
+		// First pins taken on this port - start from what is there (e.g.
+		// the pull-ups of its inputs)
+		shadow[port] = *port_register(port);
+	}
+	claimed[port] |= pins;
+	if(make_outputs) {
+		*ddr_register(port) |= pins;
+	}
+	if(interrupts_were_enabled) {
+		sei();
+	}
+	return 1;
+}
+
+uint8_t ports_claim(uint8_t port, uint8_t pins) {
+	return take_pins(port, pins, 1);
+}
+
+uint8_t ports_reserve(uint8_t port, uint8_t pins) {
+	return take_pins(port, pins, 0);
+}
+
+void ports_write(uint8_t port, uint8_t pins, uint8_t value) {
+	if(port >= NUM_PORTS) {
+		return;
+	}
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	pins &= claimed[port];
+	shadow[port] = (shadow[port] & ~pins) | (value & pins);
+	*port_register(port) = shadow[port];
+	if(interrupts_were_enabled) {
+		sei();
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ * ports.h
+ *
+ * Author: Joel Foster
+ *
+ * Output pins of the I/O ports that are shared between modules (e.g. the
+ * lives LEDs and the seven segment display are both on port C). Each
+ * module claims the pins it drives, and then only ever changes those pins
+ * through ports_write(). A copy (shadow) of each port's output register is
+ * kept, so a write doesn't need to read the port first - the new value of
+ * the port is worked out from the shadow and written in one go with
+ * interrupts off, so a write from the main program can't undo a write made
+ * by an interrupt handler part way through (or vice versa).
+ *
+ * Output pins must only be changed through ports_write() once they have
+ * been claimed. Pins driven by the microcontroller's own peripherals (e.g.
+ * the serial port) are reserved instead, so that no other module can
+ * claim them.
+ *
+ * Each module checks that its pins could be claimed, so two modules
+ * wired to the same pin are found at start up.
+ */
+
+#ifndef PORTS_H_
+#define PORTS_H_
+
+#include <stdint.h>
+
+// The ports
+#define IO_PORT_A 0
+#define IO_PORT_B 1
+#define IO_PORT_C 2
+#define IO_PORT_D 3
+
+// Make the given pins (a bit mask) of a port outputs that are driven by the
+// caller. Returns 1 if successful, 0 if any of them have already been
+// claimed (by another module) - none are claimed then.
+uint8_t ports_claim(uint8_t port, uint8_t pins);
+
+// Take the given pins of a port for the caller without changing them (for
+// pins driven by a peripheral). Returns 1 if successful, 0 if any of them
+// have already been claimed or reserved - none are reserved then.
+uint8_t ports_reserve(uint8_t port, uint8_t pins);
+
+// Set the given pins of a port to the matching bits of value (the other
+// pins don't change). Pins that haven't been claimed are left alone.
+void ports_write(uint8_t port, uint8_t pins, uint8_t value);
+
+#endif /* PORTS_H_ */
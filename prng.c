@@ -0,0 +1,51 @@
+/*
+ * prng.c
+ *
+ * Author: Joel Foster
+ */
+
+#include "prng.h"
+
+// Used in place of a seed of 0
+#define PRNG_ZERO_SEED_REPLACEMENT 0xACE1
+
+static uint16_t seed;
+static uint16_t state = PRNG_ZERO_SEED_REPLACEMENT;
+
+void prng_seed(uint16_t new_seed) {
+	seed = new_seed;
+	if(new_seed == 0) {
+		new_seed = PRNG_ZERO_SEED_REPLACEMENT;
+	}
+	state = new_seed;
+}
+
+uint16_t prng_get_seed(void) {
+	return seed;
+}
+
+uint16_t prng_get_state(void) {
+	return state;
+}
+
+void prng_set_state(uint16_t new_state) {
+	if(new_state == 0) {
+		new_state = PRNG_ZERO_SEED_REPLACEMENT;
+	}
+	state = new_state;
+}
+
+uint16_t prng_next16(void) {
+	// xorshift with shifts of 7, 9 and 8 - goes through every non-zero
+	// 16 bit value before repeating. (The shifts by 8 and 9 are just byte
+	// moves on the AVR.)
+	state ^= state << 7;
+	state ^= state >> 9;
+	state ^= state << 8;
+	return state;
+}
+
+uint8_t prng_next8(void) {
+	// The high byte is the better mixed half
+	return prng_next16() >> 8;
+}
@@ -0,0 +1,36 @@
+/*
+ * prng.h
+ *
+ * Author: Joel Foster
+ *
+ * Small pseudo-random number generator for the game (a 16 bit xorshift
+ * generator - a few shifts and XORs per number, much cheaper on the AVR
+ * than random() from the C library). The sequence of numbers depends only
+ * on the seed, so a game can be played again exactly by seeding the
+ * generator with the same value (see prng_get_seed()).
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+#include <stdint.h>
+
+// Start a new sequence of numbers from the given seed. Any value can be
+// used (0 is replaced by a fixed non-zero value, since the generator
+// would only ever return 0 from it).
+void prng_seed(uint16_t seed);
+
+// Returns the seed most recently given to prng_seed()
+uint16_t prng_get_seed(void);
+
+// Returns the generator's position in its sequence, or goes back to a
+// position returned earlier (e.g. when a saved game is restored)
+uint16_t prng_get_state(void);
+void prng_set_state(uint16_t new_state);
+
+// Return the next number in the sequence - 16 bits (1 to 65535) or
+// 8 bits (0 to 255)
+uint16_t prng_next16(void);
+uint8_t prng_next8(void);
+
+#endif /* PRNG_H_ */
@@ -0,0 +1,204 @@
+/*
+ * rewind.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "rewind.h"
+#include "game.h"
+#include "bitboard.h"
+
+// Bytes of the state that are compared before and after each tick -
+// everything up to the pac-dots (which can only be cleared, and only where
+// the pac-man is, so are dealt with separately)
+#define COMPARED_BYTES offsetof(GameState, pacdots)
+_Static_assert(COMPARED_BYTES < 256, "state offsets must fit in a byte");
+
+// The game's tick count changes every tick, so it isn't recorded - it is
+// worked out from the number of ticks each record covers instead
+#define TICKS_OFFSET offsetof(GameState, game_ticks)
+#define IS_TICKS_BYTE(offset) ((offset) >= TICKS_OFFSET \
+		&& (offset) < TICKS_OFFSET + sizeof(uint32_t))
+
+// Each record in the buffer is
+//	length			length of the whole record in bytes
+//	ticks			number of ticks from the record before to this one (1 to
+//					255) - the ticks in between changed nothing
+//	num_changed		number of bytes of the state this tick changed
+//	num_changed pairs of (offset in the state, value before the tick)
+//	a pair of bytes (low byte first) for each pac-dot or power pellet the
+//	tick cleared - its bit index (y * ROW_BITS + x), plus
+//	CLEARED_POWER_PELLET for a power pellet
+//	length			again, so the newest record can be found from the end
+#define RECORD_OVERHEAD 4
+#define MAX_RECORD_LENGTH 255
+#define MAX_RECORD_TICKS 255
+#define ROW_BITS (FIELD_ROW_WORDS * BITBOARD_WORD_BITS)
+#define CLEARED_POWER_PELLET 0x8000
+#if MAX_FIELD_HEIGHT * ROW_BITS >= CLEARED_POWER_PELLET
+#error "The field is too big for the bit indexes of the rewind records"
+#endif
+
+// The records - a ring with the oldest record at position oldest
+static uint8_t buffer[REWIND_BUFFER_SIZE];
+static uint16_t oldest;
+static uint16_t used;
+
+// Ticks since the newest record, and the level the records are for
+static uint8_t ticks_since_record;
+static uint8_t recorded_level;
+
+// The state before the tick being recorded, and the pac-dots and power
+// pellets of the (three) rows the pac-man can reach during the tick,
+// starting at row before_first_row
+static uint8_t before[COMPARED_BYTES];
+static uint8_t before_first_row;
+static uint8_t before_pacdots[3][FIELD_ROW_WORDS];
+static uint8_t before_power_pellets[3][FIELD_ROW_WORDS];
+
+static uint8_t byte_at(uint16_t position) {
+	return buffer[position % REWIND_BUFFER_SIZE];
+}
+
+static void add_byte(uint8_t value) {
+	buffer[(oldest + used) % REWIND_BUFFER_SIZE] = value;
+	used++;
+}
+
+static void drop_oldest_record(void) {
+	uint8_t length = buffer[oldest];
+	oldest = (oldest + length) % REWIND_BUFFER_SIZE;
+	used -= length;
+}
+
+// Returns the number of bits set in the before row but not in the row now
+static uint8_t count_cleared(const uint8_t* before_row, const uint8_t* row_now) {
+	uint8_t cleared[FIELD_ROW_WORDS];
+	for(uint8_t w = 0; w < FIELD_ROW_WORDS; w++) {
+		cleared[w] = before_row[w] & ~row_now[w];
+	}
+	return bitboard_popcount(cleared, FIELD_ROW_WORDS);
+}
+
+void rewind_reset(void) {
+	oldest = 0;
+	used = 0;
+	ticks_since_record = 0;
+	recorded_level = get_game_state()->level_number;
+}
+
+void rewind_before_step(void) {
+	const GameState* state = get_game_state();
+	if(state->level_number != recorded_level) {
+		// New maze - the records are no use any more
+		rewind_reset();
+	}
+	memcpy(before, state, COMPARED_BYTES);
+	before_first_row = state->pacman_y ? state->pacman_y - 1 : 0;
+	if(before_first_row > MAX_FIELD_HEIGHT - 3) {
+		before_first_row = MAX_FIELD_HEIGHT - 3;
+	}
+	memcpy(before_pacdots, state->pacdots[before_first_row], sizeof(before_pacdots));
+	memcpy(before_power_pellets, state->power_pellets[before_first_row],
+			sizeof(before_power_pellets));
+}
+
+void rewind_after_step(void) {
+	const GameState* state = get_game_state();
+	const uint8_t* now = (const uint8_t*)state;
+	// Work out the size of the record first so we know how much room it needs
+	uint8_t num_changed = 0;
+	for(uint8_t i = 0; i < COMPARED_BYTES; i++) {
+		if(now[i] != before[i] && !IS_TICKS_BYTE(i)) {
+			num_changed++;
+		}
+	}
+	uint8_t num_cleared = 0;
+	for(uint8_t row = 0; row < 3; row++) {
+		uint8_t y = before_first_row + row;
+		num_cleared += count_cleared(before_pacdots[row], state->pacdots[y]);
+		num_cleared += count_cleared(before_power_pellets[row], state->power_pellets[y]);
+	}
+	if(num_changed == 0 && num_cleared == 0
+			&& ticks_since_record < MAX_RECORD_TICKS - 1) {
+		// Nothing to record (an empty record is added every
+		// MAX_RECORD_TICKS ticks so the tick count can be worked out)
+		ticks_since_record++;
+		return;
+	}
+	uint16_t length = RECORD_OVERHEAD + 2 * num_changed + 2 * num_cleared;
+	if(length > MAX_RECORD_LENGTH || length > REWIND_BUFFER_SIZE) {
+		// Too much has changed to keep - we can't step back past here
+		rewind_reset();
+		return;
+	}
+	while(REWIND_BUFFER_SIZE - used < length) {
+		drop_oldest_record();
+	}
+	add_byte(length);
+	add_byte(ticks_since_record + 1);
+	add_byte(num_changed);
+	for(uint8_t i = 0; i < COMPARED_BYTES; i++) {
+		if(now[i] != before[i] && !IS_TICKS_BYTE(i)) {
+			add_byte(i);
+			add_byte(before[i]);
+		}
+	}
+	for(uint8_t row = 0; row < 3; row++) {
+		uint8_t y = before_first_row + row;
+		for(uint8_t x = 0; x < ROW_BITS; x++) {
+			uint16_t index = y * ROW_BITS + x;
+			if(bitboard_test(before_pacdots[row], x)
+					&& !bitboard_test(state->pacdots[y], x)) {
+				add_byte(index & 0xFF);
+				add_byte(index >> 8);
+			}
+			if(bitboard_test(before_power_pellets[row], x)
+					&& !bitboard_test(state->power_pellets[y], x)) {
+				index |= CLEARED_POWER_PELLET;
+				add_byte(index & 0xFF);
+				add_byte(index >> 8);
+			}
+		}
+	}
+	add_byte(length);
+	ticks_since_record = 0;
+}
+
+uint8_t rewind_step_back(void) {
+	if(used == 0) {
+		return 0;
+	}
+	uint16_t end = oldest + used;
+	uint8_t length = byte_at(end - 1);
+	uint16_t position = end - length;
+	uint8_t ticks = byte_at(position + 1);
+	uint8_t num_changed = byte_at(position + 2);
+	position += 3;
+	GameState* state = game_change_begin();
+	uint8_t* bytes = (uint8_t*)state;
+	for(uint8_t i = 0; i < num_changed; i++) {
+		uint8_t offset = byte_at(position++);
+		bytes[offset] = byte_at(position++);
+	}
+	while(position < end - 1) {
+		uint16_t index = byte_at(position) | (byte_at(position + 1) << 8);
+		position += 2;
+		uint8_t y = (index & ~CLEARED_POWER_PELLET) / ROW_BITS;
+		uint8_t x = (index & ~CLEARED_POWER_PELLET) % ROW_BITS;
+		if(index & CLEARED_POWER_PELLET) {
+			bitboard_set(state->power_pellets[y], x);
+		} else {
+			bitboard_set(state->pacdots[y], x);
+		}
+		game_cell_changed(x, y);
+	}
+	// Back to the end of the tick before the one recorded
+	state->game_ticks -= ticks_since_record + 1;
+	ticks_since_record = ticks - 1;
+	used -= length;
+	game_change_end();
+	return 1;
+}
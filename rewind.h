@@ -0,0 +1,44 @@
+/*
+ * rewind.h
+ *
+ * Author: Joel Foster
+ *
+ * Rewind buffer - lets the game be stepped back through the last second or
+ * so (e.g. to look at what happened just before the pac-man died).
+ * A full copy of the game state (see GameState in game.h) is a few hundred
+ * bytes, so rather than keeping copies we keep what each tick changed:
+ * the old value of every byte of the state (other than the pac-dots and
+ * power pellets) that the tick changed and the position of every pac-dot
+ * or power pellet it cleared. The live state is the starting point, and
+ * stepping back undoes the most recent tick that changed anything. The
+ * oldest ticks are forgotten when the buffer fills up.
+ */
+
+#ifndef REWIND_H_
+#define REWIND_H_
+
+#include <stdint.h>
+
+// Number of bytes kept for the changes. Each pac-man or ghost move takes
+// about 6 bytes, so this covers only about a second of play (less on levels
+// with more ghosts) - 256 bytes would cover nearer three seconds, but the
+// LED matrix frame buffer (see ledmatrix.c) needs the RAM.
+#ifndef REWIND_BUFFER_SIZE
+#define REWIND_BUFFER_SIZE 128
+#endif
+
+// Forget everything recorded so far (e.g. when a new game starts or a game
+// is loaded). This also happens by itself when the level changes.
+void rewind_reset(void);
+
+// Record what game_step() changes - rewind_before_step() must be called
+// just before it and rewind_after_step() just after it
+void rewind_before_step(void);
+void rewind_after_step(void);
+
+// Step the game back to before the most recent tick that changed anything
+// (and redraw what changed). Returns 1 if successful, 0 if there is nothing
+// left to step back through.
+uint8_t rewind_step_back(void);
+
+#endif /* REWIND_H_ */
@@ -0,0 +1,99 @@
+/*
+ * rle.c
+ *
+ * Author: Joel Foster
+ */
+
+#include "rle.h"
+
+#define MAX_COPIED_CONTROL 127
+#define FIRST_RUN_CONTROL 128
+#define MAX_RUN_CONTROL 255
+// Number of times the byte of a run is repeated is the control byte minus
+// this
+#define RUN_CONTROL_OFFSET 125
+
+void rle_writer_start(RleWriter* writer, uint8_t* buffer, uint8_t size) {
+	writer->buffer = buffer;
+	writer->size = size;
+	writer->length = 0;
+	writer->control = 0;
+	writer->in_run = 0;
+}
+
+uint8_t rle_writer_add(RleWriter* writer, uint8_t value) {
+	uint8_t* buffer = writer->buffer;
+	if(writer->length) {
+		uint8_t control = buffer[writer->control];
+		if(writer->in_run) {
+			if(buffer[writer->length - 1] == value && control < MAX_RUN_CONTROL) {
+				buffer[writer->control]++;
+				return 1;
+			}
+		} else if(control >= 1 && buffer[writer->length - 1] == value
+				&& buffer[writer->length - 2] == value) {
+			// The last two bytes copied and this one become a run (this
+			// never takes more room than copying them did)
+			if(control == 1) {
+				// They were the whole block
+				writer->length = writer->control;
+			} else {
+				buffer[writer->control] -= 2;
+				writer->length -= 2;
+			}
+			writer->control = writer->length;
+			buffer[writer->length++] = FIRST_RUN_CONTROL;
+			buffer[writer->length++] = value;
+			writer->in_run = 1;
+			return 1;
+		} else if(control < MAX_COPIED_CONTROL) {
+			if(writer->length == writer->size) {
+				return 0;
+			}
+			buffer[writer->length++] = value;
+			buffer[writer->control]++;
+			return 1;
+		}
+	}
+	// Start a new block of copied bytes
+	if(writer->size - writer->length < 2) {
+		return 0;
+	}
+	writer->control = writer->length;
+	buffer[writer->length++] = 0;
+	buffer[writer->length++] = value;
+	writer->in_run = 0;
+	return 1;
+}
+
+void rle_reader_start(RleReader* reader, const uint8_t* data, uint8_t length) {
+	reader->next = data;
+	reader->end = data + length;
+	reader->remaining = 0;
+	reader->in_run = 0;
+}
+
+int16_t rle_reader_next(RleReader* reader) {
+	if(reader->remaining == 0) {
+		// Start of the next block - there must be a byte after the control
+		// byte
+		if(reader->end - reader->next < 2) {
+			return -1;
+		}
+		uint8_t control = *reader->next++;
+		reader->in_run = (control >= FIRST_RUN_CONTROL);
+		if(reader->in_run) {
+			reader->remaining = control - RUN_CONTROL_OFFSET;
+		} else {
+			reader->remaining = control + 1;
+		}
+	}
+	if(reader->next >= reader->end) {
+		return -1;
+	}
+	reader->remaining--;
+	if(reader->in_run && reader->remaining) {
+		return *reader->next;
+	}
+	return *reader->next++;
+}
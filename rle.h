@@ -0,0 +1,52 @@
+/*
+ * rle.h
+ *
+ * Author: Joel Foster
+ *
+ * Run length encoding of bytes in RAM (e.g. the pac-dots of a saved game -
+ * see game_pack_dots() in game.h). The encoded data is a series of blocks,
+ * each starting with a control byte:
+ *	0 to 127		the next (control + 1) bytes are copied as they are
+ *	128 to 255		the next byte is repeated (control - 125) times (3 to 130)
+ * Bytes are encoded one at a time as they are added, without looking ahead,
+ * and the encoded data is never more than RLE_MAX_LENGTH() bytes.
+ */
+
+#ifndef RLE_H_
+#define RLE_H_
+
+#include <stdint.h>
+
+// Largest size of the encoded data for length bytes
+#define RLE_MAX_LENGTH(length) ((length) + ((length) + 126) / 127 + 1)
+
+typedef struct {
+	uint8_t* buffer;
+	uint8_t size;			// size of the buffer
+	uint8_t length;			// bytes of the buffer used so far
+	uint8_t control;		// position of the control byte of the last block
+	uint8_t in_run;			// 1 if the last block is a repeated byte
+} RleWriter;
+
+typedef struct {
+	const uint8_t* next;	// next byte of the encoded data
+	const uint8_t* end;
+	uint8_t remaining;		// bytes left in the current block
+	uint8_t in_run;			// 1 if the current block is a repeated byte
+} RleReader;
+
+// Start encoding into the given buffer (of size bytes)
+void rle_writer_start(RleWriter* writer, uint8_t* buffer, uint8_t size);
+
+// Add a byte to the encoded data. Returns 1 if successful, 0 if there is no
+// room left in the buffer.
+uint8_t rle_writer_add(RleWriter* writer, uint8_t value);
+
+// Start decoding length bytes of encoded data
+void rle_reader_start(RleReader* reader, const uint8_t* data, uint8_t length);
+
+// Returns the next decoded byte, or -1 if there are none left (or the data
+// is not valid)
+int16_t rle_reader_next(RleReader* reader);
+
+#endif /* RLE_H_ */
@@ -0,0 +1,288 @@
+/*
+ * saved_game.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "saved_game.h"
+#include "eeprom_queue.h"
+#include "game.h"
+#include "crc16.h"
+
+// Layout of the slots - changed whenever the layout (or GameState) changes
+// so that older saves are ignored
+#define SAVE_FORMAT 5
+
+#if SAVE_SLOTS < 3
+#error "SAVE_SLOTS must be at least 3 (a full save, the newest and the one being written)"
+#endif
+
+// The part of the game's state that is saved as it is - the pac-dots and
+// power pellets after it are packed
+#define SAVED_STATE_BYTES offsetof(GameState, pacdots)
+
+// Each changed row of a partial save is its row number followed by the row
+// of pac-dots and the row of power pellets
+#define CHANGED_ROW_BYTES (1 + 2 * FIELD_ROW_WORDS)
+
+typedef struct {
+	uint16_t crc;			// CRC (see crc16.h) of the rest of the slot
+							// up to the end of the packed dots
+	uint8_t format;			// SAVE_FORMAT
+	uint16_t sequence;		// one more than the slot saved before
+	uint16_t base_sequence;	// sequence number of the full save that a
+							// partial save changes (its own for a full save)
+	uint8_t dots_length;	// number of bytes of dots used
+	uint8_t state[SAVED_STATE_BYTES];
+	uint8_t dots[GAME_PACKED_DOTS_SIZE];
+} SaveSlot;
+
+#define CRC_BYTES sizeof(uint16_t)
+#define SLOT_LENGTH(dots_length) (offsetof(SaveSlot, dots) + (dots_length))
+
+static SaveSlot EEMEM slots[SAVE_SLOTS];
+
+// The slot being written or read
+static SaveSlot slot;
+
+// Position of the newest slot (-1 if there are no saved games) and its
+// sequence number
+static int8_t newest_slot;
+static uint16_t newest_sequence;
+
+// Position of the full save the newest slot is based on (the newest slot
+// itself if it is a full save), and its sequence number. This slot is
+// never written over (a save cut short may leave a partial save based on
+// it as the newest).
+static int8_t base_slot;
+static uint16_t base_sequence;
+
+// The slot being written (if a save is in progress)
+static uint8_t slot_being_written;
+static uint8_t save_in_progress;
+static uint8_t save_again;
+static uint8_t save_finished;
+
+// Returns 1 if slot n in the EEPROM holds a save (it has the right format
+// and CRC), 0 otherwise
+static uint8_t slot_is_valid(uint8_t n) {
+	const uint8_t* bytes = (const uint8_t*)&slots[n];
+	uint8_t dots_length = eeprom_read_byte(&slots[n].dots_length);
+	if(eeprom_read_byte(&slots[n].format) != SAVE_FORMAT
+			|| dots_length > GAME_PACKED_DOTS_SIZE) {
+		return 0;
+	}
+	uint16_t crc = CRC16_INITIAL_VALUE;
+	for(uint8_t i = CRC_BYTES; i < SLOT_LENGTH(dots_length); i++) {
+		crc = crc16_update(crc, eeprom_read_byte(&bytes[i]));
+	}
+	return crc == eeprom_read_word(&slots[n].crc);
+}
+
+// Returns the position of the valid full save with the given sequence
+// number, or -1 if there isn't one
+static int8_t find_full_save(uint16_t sequence) {
+	for(uint8_t i = 0; i < SAVE_SLOTS; i++) {
+		if(eeprom_read_word(&slots[i].sequence) == sequence
+				&& eeprom_read_word(&slots[i].base_sequence) == sequence
+				&& slot_is_valid(i)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Read slot n from the EEPROM into slot and check it again (in case it has
+// gone bad since start up). Returns 1 if it is valid, 0 otherwise.
+static uint8_t read_slot(uint8_t n) {
+	eeprom_read_block(&slot, &slots[n], sizeof(slot));
+	return slot.format == SAVE_FORMAT
+			&& slot.dots_length <= GAME_PACKED_DOTS_SIZE
+			&& slot.crc == crc16_block(CRC16_INITIAL_VALUE, &slot.format,
+			SLOT_LENGTH(slot.dots_length) - CRC_BYTES);
+}
+
+// Put the rows of the game's pac-dots and power pellets that are marked as
+// changed into slot. Returns the number of bytes used.
+static uint8_t copy_changed_rows(uint32_t rows) {
+	GameState* state = get_game_state();
+	uint8_t length = 0;
+	for(uint8_t y = 0; y < MAX_FIELD_HEIGHT; y++) {
+		if(rows & ((uint32_t)1 << y)) {
+			slot.dots[length++] = y;
+			memcpy(&slot.dots[length], state->pacdots[y], FIELD_ROW_WORDS);
+			length += FIELD_ROW_WORDS;
+			memcpy(&slot.dots[length], state->power_pellets[y], FIELD_ROW_WORDS);
+			length += FIELD_ROW_WORDS;
+		}
+	}
+	return length;
+}
+
+// Returns 1 if the changed rows in slot (a partial save) can go on top of
+// the given full save, 0 otherwise
+static uint8_t changed_rows_fit(uint8_t full_save) {
+	if(slot.state[offsetof(GameState, level_number)] != eeprom_read_byte(
+			&slots[full_save].state[offsetof(GameState, level_number)])
+			|| slot.dots_length % CHANGED_ROW_BYTES) {
+		return 0;
+	}
+	for(uint8_t i = 0; i < slot.dots_length; i += CHANGED_ROW_BYTES) {
+		if(slot.dots[i] >= MAX_FIELD_HEIGHT) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void saved_game_init(void) {
+	newest_slot = -1;
+	base_slot = -1;
+	for(uint8_t i = 0; i < SAVE_SLOTS; i++) {
+		if(!slot_is_valid(i)) {
+			continue;
+		}
+		uint16_t sequence = eeprom_read_word(&slots[i].sequence);
+		// A partial save is no use without its full save
+		int8_t full_save = find_full_save(eeprom_read_word(&slots[i].base_sequence));
+		if(full_save < 0) {
+			continue;
+		}
+		// (Sequence numbers wrap around, so the newer of two is the one
+		// less than half way round ahead of the other)
+		if(newest_slot < 0 || (int16_t)(sequence - newest_sequence) > 0) {
+			newest_slot = i;
+			newest_sequence = sequence;
+			base_slot = full_save;
+			base_sequence = eeprom_read_word(&slots[full_save].sequence);
+		}
+	}
+}
+
+void saved_game_start(void) {
+	if(save_in_progress || eeprom_queue_busy()) {
+		// What is being written is already out of date (or the queue may
+		// not have room for both blocks) - save once it has finished
+		save_again = 1;
+		return;
+	}
+	slot.format = SAVE_FORMAT;
+	slot.sequence = newest_sequence + 1;
+	memcpy(slot.state, get_game_state(), SAVED_STATE_BYTES);
+	slot.dots_length = game_pack_dots(slot.dots);
+	// If fewer bytes are needed for just the rows that have changed since
+	// the last full save then this is a partial save based on it
+	uint32_t rows = game_changed_rows();
+	uint16_t changed_length = 0;
+	for(uint8_t y = 0; y < MAX_FIELD_HEIGHT; y++) {
+		if(rows & ((uint32_t)1 << y)) {
+			changed_length += CHANGED_ROW_BYTES;
+		}
+	}
+	if(base_slot >= 0 && changed_length < slot.dots_length) {
+		slot.base_sequence = base_sequence;
+		slot.dots_length = copy_changed_rows(rows);
+	} else {
+		slot.base_sequence = slot.sequence;
+	}
+	uint8_t length = SLOT_LENGTH(slot.dots_length);
+	slot.crc = crc16_block(CRC16_INITIAL_VALUE, &slot.format, length - CRC_BYTES);
+	// Into the slot after the newest one (but not the full save). The CRC
+	// goes last so the slot isn't valid until everything else is there.
+	slot_being_written = newest_slot;
+	do {
+		slot_being_written = (slot_being_written + 1) % SAVE_SLOTS;
+	} while(slot_being_written == base_slot);
+	// If either block can't be queued the save is tried again once the
+	// queue is empty. (Without its CRC the slot is just left invalid, and
+	// it's never the newest or the full save.)
+	if(!eeprom_queue_write(&slots[slot_being_written].format, &slot.format,
+			length - CRC_BYTES) ||
+			!eeprom_queue_write(&slots[slot_being_written].crc, &slot.crc,
+			CRC_BYTES)) {
+		save_again = 1;
+		return;
+	}
+	// Only now is this the full save later partial saves are based on
+	if(slot.base_sequence == slot.sequence) {
+		game_clear_changed_rows();
+	}
+	save_in_progress = 1;
+}
+
+void saved_game_continue(void) {
+	if(eeprom_queue_busy()) {
+		return;
+	}
+	if(save_in_progress) {
+		newest_slot = slot_being_written;
+		newest_sequence = slot.sequence;
+		if(slot.base_sequence == slot.sequence) {
+			base_slot = slot_being_written;
+			base_sequence = slot.sequence;
+		}
+		save_in_progress = 0;
+		save_finished = 1;
+	}
+	if(save_again) {
+		save_again = 0;
+		saved_game_start();
+	}
+}
+
+uint8_t saved_game_in_progress(void) {
+	return save_in_progress || save_again;
+}
+
+uint8_t saved_game_finished(void) {
+	if(save_finished) {
+		save_finished = 0;
+		return 1;
+	}
+	return 0;
+}
+
+void saved_game_wait(void) {
+	while(save_in_progress || save_again) {
+		saved_game_continue();
+	}
+}
+
+uint8_t saved_game_available(void) {
+	return save_in_progress || save_again || newest_slot >= 0;
+}
+
+uint8_t saved_game_load(void) {
+	saved_game_wait();
+	if(newest_slot < 0) {
+		return 0;
+	}
+	// A partial save is checked before anything is changed, then the full
+	// save is unpacked and the changed rows put on top
+	uint8_t partial = (newest_slot != base_slot);
+	if(partial && !(read_slot(newest_slot) && changed_rows_fit(base_slot))) {
+		return 0;
+	}
+	if(!read_slot(base_slot) || !game_unpack_dots(
+			slot.state[offsetof(GameState, level_number)],
+			slot.dots, slot.dots_length)) {
+		return 0;
+	}
+	GameState* state = get_game_state();
+	if(partial) {
+		// (Checked above)
+		read_slot(newest_slot);
+		for(uint8_t i = 0; i < slot.dots_length; i += CHANGED_ROW_BYTES) {
+			uint8_t y = slot.dots[i];
+			memcpy(state->pacdots[y], &slot.dots[i + 1], FIELD_ROW_WORDS);
+			memcpy(state->power_pellets[y], &slot.dots[i + 1 + FIELD_ROW_WORDS],
+					FIELD_ROW_WORDS);
+		}
+	}
+	memcpy(state, slot.state, SAVED_STATE_BYTES);
+	return 1;
+}
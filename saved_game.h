@@ -0,0 +1,63 @@
+/*
+ * saved_game.h
+ *
+ * Author: Joel Foster
+ *
+ * Saving the game in the EEPROM. There are SAVE_SLOTS
+ * slots and each save goes in the slot after the one saved before it, so
+ * the EEPROM wears evenly and the previous save is still there if a save
+ * is cut short (e.g. the power is turned off). Each slot has a sequence
+ * number (one more than the slot saved before it) and a CRC of its
+ * contents - the newest slot with the right CRC is the one loaded. The
+ * pac-dots and power pellets are packed (see game_pack_dots() in game.h)
+ * so a slot is small and only the bytes used are written.
+ *
+ * Most saves are partial - they only have the rows of pac-dots and power
+ * pellets that have changed since the last full save (see
+ * game_changed_rows() in game.h) and are loaded on top of it. A full save
+ * is made instead whenever that would be smaller (e.g. a new level, or
+ * after a lot has been eaten), and the slot of the full save the newest
+ * is based on is left alone until there is a newer full save.
+ *
+ * A save is copied into a slot in RAM and written in the background (see
+ * eeprom_queue.h) while the game carries on.
+ */
+
+#ifndef SAVED_GAME_H_
+#define SAVED_GAME_H_
+
+#include <stdint.h>
+
+// Number of slots in the EEPROM
+#define SAVE_SLOTS 4
+
+// Find the newest saved game in the EEPROM - must be called once at start
+// up before anything else here
+void saved_game_init(void);
+
+// Start saving the game. If a save (or anything else) is already being
+// written to the EEPROM the game is saved once it has finished.
+void saved_game_start(void);
+
+// Move a save along - this must be called regularly until the save has
+// finished
+void saved_game_continue(void);
+
+// Returns 1 if a save is under way, 0 otherwise
+uint8_t saved_game_in_progress(void);
+
+// Returns 1 (once) when a save has finished - 0 otherwise
+uint8_t saved_game_finished(void);
+
+// Finish any save that is under way
+void saved_game_wait(void);
+
+// Returns 1 if there is a saved game in the EEPROM, 0 otherwise
+uint8_t saved_game_available(void);
+
+// Load the newest saved game from the EEPROM into the
+// game's state. Returns 1 if successful, 0 if there is no saved game. The
+// caller must tell the game its state has changed.
+uint8_t saved_game_load(void);
+
+#endif /* SAVED_GAME_H_ */
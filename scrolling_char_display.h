@@ -1,34 +1,54 @@
-/*
- * scrolling_char_display.h
- *
- * Author: Peter Sutton
- */
-
-#ifndef SCROLLING_CHAR_DISPLAY_H_
-#define SCROLLING_CHAR_DISPLAY_H_
-
-#include <stdint.h>
-#include "pixel_colour.h"
-
-/* Sets the text to be displayed and the colour it will be
- * scrolled with. The message will start displaying immediately
- * so will overwrite/interfere with any currently scrolling
- * message. To avoid this, wait until the scroll_display()
- * function below has returned 0 to indicate the message scrolling
- * is complete. Note that this string is not 
- * copied, so it is important that this string not change
- * after this function is called while the string is still
- * being displayed.
- */
-void set_scrolling_display_text(char* string, PixelColour colour);
-
-/* Scroll the display. Should be called whenever the display
- * is to be scrolled one pixel to the left. It is recommended that
- * this function NOT be called from an interrupt service routine as
- * it will wait for SPI communication to be finished before returning. 
- * This could take over 1ms.
- * Returns 1 while a message is still scrolling, 0 when done.
- */
-uint8_t scroll_display(void);
-	
+/*
+ * scrolling_char_display.h
+ *
+ * Author: Peter Sutton
+ */
+
+#ifndef SCROLLING_CHAR_DISPLAY_H_
+#define SCROLLING_CHAR_DISPLAY_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+/* Time (in milliseconds) between scrolling the display one pixel
+ * to the left.
+ */
+#define SCROLL_STEP_MS 150
+
+/* Number of columns of the message rendered ahead of being
+ * displayed.
+ */
+#define SCROLL_QUEUE_SIZE 8
+
+/* Sets the text to be displayed and the colour it will be
+ * scrolled with. The message will start displaying immediately
+ * so will overwrite/interfere with any currently scrolling
+ * message. To avoid this, wait until scrolling_display_update()
+ * below has returned 0 to indicate the message scrolling
+ * is complete. Note that this string is not 
+ * copied, so it is important that this string not change
+ * after this function is called while the string is still
+ * being displayed.
+ */
+void set_scrolling_display_text(const char* string, PixelColour colour);
+
+/* Scroll the display one pixel to the left every SCROLL_STEP_MS
+ * (timed by timer 0 - see timer0.h). Should be called each time
+ * round the program's main loop. The columns of the message are
+ * rendered from the font ahead of time, so each call takes little
+ * more than queuing the shift and the new pixels for the LED
+ * matrix (through its frame buffer) - it never waits for them to
+ * be sent. Anything else drawn on the LED matrix is scrolled off
+ * to the left by the message.
+ * Returns 1 while a message is still scrolling, 0 when done.
+ */
+uint8_t scrolling_display_update(void);
+
+/* Scroll the display one pixel to the left straight away. Like
+ * scrolling_display_update() this returns without waiting for
+ * the SPI communication to finish.
+ * Returns 1 while a message is still scrolling, 0 when done.
+ */
+uint8_t scroll_display(void);
+	
 #endif /* SCROLLING_CHAR_DISPLAY_H_ */
\ No newline at end of file
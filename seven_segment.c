@@ -0,0 +1,92 @@
+/*
+ * seven_segment.c
+ *
+ * Author: Joel Foster
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "seven_segment.h"
+#include "ports.h"
+
+// Segments lit for each digit (bit 0 is segment A ... bit 6 is segment G)
+static const uint8_t digit_segments[10] PROGMEM = {
+	63, 6, 91, 79, 102, 109, 125, 7, 127, 111
+};
+
+// Segments on each port, and the digit select pin. Segments A to D (bits 0
+// to 3 of the segments) are moved up to port D pins 4 to 7 - port D pins 0
+// and 1 are the serial port.
+#define PORTD_SEGMENTS 0xF0
+#define PORTD_SEGMENTS_SHIFT 4
+#define PORTC_SEGMENTS 0xF0
+#define DIGIT_SELECT (1<<PORTD2)
+
+#if (PORTD_SEGMENTS & DIGIT_SELECT)
+#error "The digit select must not be one of the segment pins"
+#endif
+
+// Segments to be shown on the right (0) and left (1) digits - 0 is blank -
+// and the digit being shown
+static volatile uint8_t segments[2];
+static uint8_t digit;
+
+uint8_t seven_segment_init(void) {
+	segments[0] = 0;
+	segments[1] = 0;
+	digit = 0;
+	// The digit select is claimed on its own, so it can't share a pin
+	// with a segment
+	if(!ports_claim(IO_PORT_D, PORTD_SEGMENTS)
+			|| !ports_claim(IO_PORT_D, DIGIT_SELECT)
+			|| !ports_claim(IO_PORT_C, PORTC_SEGMENTS)) {
+		return 0;
+	}
+	ports_write(IO_PORT_D, PORTD_SEGMENTS | DIGIT_SELECT, 0);
+	ports_write(IO_PORT_C, PORTC_SEGMENTS, 0);
+	return 1;
+}
+
+void seven_segment_show_number(uint8_t number) {
+	uint8_t right = pgm_read_byte(&digit_segments[number % 10]);
+	uint8_t left = 0;
+	number = (number / 10) % 10;
+	if(number) {
+		left = pgm_read_byte(&digit_segments[number]);
+	}
+	// Both digits are changed together, so the interrupt handler doesn't
+	// show half of the old number
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	segments[0] = right;
+	segments[1] = left;
+	if(interrupts_were_enabled) {
+		sei();
+	}
+}
+
+void seven_segment_blank(void) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	segments[0] = 0;
+	segments[1] = 0;
+	if(interrupts_were_enabled) {
+		sei();
+	}
+}
+
+void seven_segment_refresh(void) {
+	// Move on to the other digit unless it is blank
+	if(segments[digit ^ 1]) {
+		digit ^= 1;
+	}
+	uint8_t lit = segments[digit];
+	// Turn the port C segments off before the digit select changes, so
+	// the segments of one digit are never shown on the other (the port D
+	// segments change in the same write as the digit select)
+	ports_write(IO_PORT_C, PORTC_SEGMENTS, 0);
+	ports_write(IO_PORT_D, PORTD_SEGMENTS | DIGIT_SELECT,
+			(uint8_t)(lit << PORTD_SEGMENTS_SHIFT) | (digit ? DIGIT_SELECT : 0));
+	ports_write(IO_PORT_C, PORTC_SEGMENTS, lit);
+}
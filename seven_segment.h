@@ -0,0 +1,38 @@
+/*
+ * seven_segment.h
+ *
+ * Author: Joel Foster
+ *
+ * Two digit seven segment display, refreshed from the timer 0 interrupt
+ * handler (see timer0.c) - each millisecond the segments are turned off,
+ * the other digit is selected and its segments are turned on. The game
+ * just writes the number to be shown and the display stays steady however
+ * fast the game loop is going. A blank digit is skipped (so a one digit
+ * number is as bright as a two digit one).
+ *
+ * Segments A to D are on port D pins 4 to 7, segments E to G and the
+ * decimal point on port C pins 4 to 7, and the digit is selected by port D
+ * pin 2 (1 for the left digit).
+ */
+
+#ifndef SEVEN_SEGMENT_H_
+#define SEVEN_SEGMENT_H_
+
+#include <stdint.h>
+
+// Claim the port pins (see ports.h) and blank the display. Returns 1 if
+// successful, 0 if any of the pins have already been claimed.
+uint8_t seven_segment_init(void);
+
+// Show a number from 0 to 99 (larger numbers show their last two digits).
+// A leading zero is not shown.
+void seven_segment_show_number(uint8_t number);
+
+// Turn the display off
+void seven_segment_blank(void);
+
+// Show the next digit - called by the timer 0 interrupt handler every
+// millisecond
+void seven_segment_refresh(void);
+
+#endif /* SEVEN_SEGMENT_H_ */
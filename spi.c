@@ -1,69 +1,156 @@
-/*
- * spi.c
- *
- * Author: Peter Sutton
- */ 
-
-#include <avr/io.h>
-#include "spi.h"
-
-void spi_setup_master(uint8_t clockdivider) {
-	// Set up SPI communication as a master
-	// Make the SS, MOSI and SCK pins outputs. These are pins
-	// 4, 5 and 7 of port B on the ATmega324A
-	
-	DDRB |= (1<<4)|(1<<5)|(1<<7);
-	
-	// Set the slave select (SS) line high
-	PORTB |= (1<<4);
-	
-	// Set up the SPI control registers SPCR and SPSR:
-	// - SPE bit = 1 (SPI is enabled)
-	// - MSTR bit = 1 (Master Mode)
-	SPCR0 = (1<<SPE0)|(1<<MSTR0);
-	
-	// Set SPR0 and SPR1 bits in SPCR and SPI2X bit in SPSR
-	// based on the given clock divider
-	// Invalid values default to the slowest speed
-	// We consider each bit in turn
-	switch(clockdivider) {
-		case 2:
-		case 8:
-		case 32:
-			SPSR0 = (1<<SPI2X0);
-			break;
-		default:
-			SPSR0 = 0;
-			break;
-	}
-	switch(clockdivider) {
-		case 128:
-			SPCR0 |= (1<<SPR00);
-			// Note this flows through to the next code block
-		case 32:
-		case 64:
-			SPCR0 |= (1<<SPR10);
-			break;
-		case 8:
-		case 16:
-			SPCR0 |= (1<<SPR00);
-			break;
-	}
-	
-	// Take SS (slave select) line low
-	PORTB &= ~(1<<4);
-}
-
-uint8_t spi_send_byte(uint8_t byte) {
-	// Write out the byte to the SPDR0 register. This will initiate
-	// the transfer. We then wait until the most significant byte of
-	// SPSR0 (SPIF0 bit) is set - this indicates that the transfer is
-	// complete. (The final read of SPSR0 followed by a read of SPDR0
-	// will cause the SPIF bit to be reset to 0. See page 173 of the 
-	// ATmega324A datasheet.)
-	SPDR0 = byte;
-	while((SPSR0 & (1<<SPIF0)) == 0) {
-		; // wait
-	}
-	return SPDR0;
-}
\ No newline at end of file
+/*
+ * spi.c
+ *
+ * Author: Peter Sutton
+ */ 
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "spi.h"
+#include "ports.h"
+
+// The queue of bytes to be sent - a ring starting at position first. The
+// byte being sent has already been taken out of it, and transfer_active is
+// 1 until the interrupt handler finds nothing left to send. The queue is
+// changed by the interrupt handler below so interrupts are turned off when
+// changing it outside the handler.
+static volatile uint8_t queue[SPI_QUEUE_SIZE];
+static volatile uint8_t first;
+static volatile uint8_t queue_length;
+static volatile uint8_t transfer_active;
+
+uint8_t spi_setup_master(uint8_t clockdivider) {
+	// Set up SPI communication as a master
+	// Make the SS, MOSI and SCK pins outputs. These are pins
+	// 4, 5 and 7 of port B on the ATmega324A
+	
+	if(!ports_claim(IO_PORT_B, (1<<4)|(1<<5)|(1<<7))) {
+		return 0;
+	}
+	
+	// Set the slave select (SS) line high
+	ports_write(IO_PORT_B, (1<<4), (1<<4));
+	
+	// Set up the SPI control registers SPCR and SPSR:
+	// - SPE bit = 1 (SPI is enabled)
+	// - MSTR bit = 1 (Master Mode)
+	SPCR0 = (1<<SPE0)|(1<<MSTR0);
+	
+	// Set SPR0 and SPR1 bits in SPCR and SPI2X bit in SPSR
+	// based on the given clock divider
+	// Invalid values default to the slowest speed
+	// We consider each bit in turn
+	switch(clockdivider) {
+		case 2:
+		case 8:
+		case 32:
+			SPSR0 = (1<<SPI2X0);
+			break;
+		default:
+			SPSR0 = 0;
+			break;
+	}
+	switch(clockdivider) {
+		case 128:
+			SPCR0 |= (1<<SPR00);
+			// Note this flows through to the next code block
+		case 32:
+		case 64:
+			SPCR0 |= (1<<SPR10);
+			break;
+		case 8:
+		case 16:
+			SPCR0 |= (1<<SPR00);
+			break;
+	}
+	
+	// Take SS (slave select) line low
+	ports_write(IO_PORT_B, (1<<4), 0);
+	return 1;
+}
+
+uint8_t spi_send_byte(uint8_t byte) {
+	// The queued bytes go first (and the interrupt is turned off once
+	// they have gone, so it won't clear SPIF0 before we see it below)
+	spi_flush();
+	// Write out the byte to the SPDR0 register. This will initiate
+	// the transfer. We then wait until the most significant byte of
+	// SPSR0 (SPIF0 bit) is set - this indicates that the transfer is
+	// complete. (The final read of SPSR0 followed by a read of SPDR0
+	// will cause the SPIF bit to be reset to 0. See page 173 of the 
+	// ATmega324A datasheet.)
+	SPDR0 = byte;
+	while((SPSR0 & (1<<SPIF0)) == 0) {
+		; // wait
+	}
+	return SPDR0;
+}
+
+// Start sending the next queued byte - or, if there isn't one, note that
+// we have stopped and turn off the interrupt. The last transfer must have
+// finished.
+static void start_next_transfer(void) {
+	if(queue_length) {
+		SPDR0 = queue[first];
+		first = (first + 1) % SPI_QUEUE_SIZE;
+		queue_length--;
+	} else {
+		transfer_active = 0;
+		SPCR0 &= ~(1<<SPIE0);
+	}
+}
+
+// Send the queued bytes ourselves - used when interrupts are disabled (so
+// the interrupt handler can't). Waits for the transfer under way to finish
+// and starts the next one.
+static void poll_transfer(void) {
+	while((SPSR0 & (1<<SPIF0)) == 0) {
+		; // wait
+	}
+	// Reading SPDR0 after SPSR0 clears SPIF0
+	(void)SPDR0;
+	start_next_transfer();
+}
+
+void spi_queue_byte(uint8_t byte) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	while(queue_length == SPI_QUEUE_SIZE) {
+		if(!interrupts_were_enabled) {
+			poll_transfer();
+		}
+		// else wait for the interrupt handler to make room
+	}
+	cli();
+	if(transfer_active) {
+		queue[(first + queue_length) % SPI_QUEUE_SIZE] = byte;
+		queue_length++;
+	} else {
+		// Nothing being sent - send this one straight away. The interrupt
+		// fires when it has gone.
+		transfer_active = 1;
+		SPDR0 = byte;
+		SPCR0 |= (1<<SPIE0);
+	}
+	if(interrupts_were_enabled) {
+		sei();
+	}
+}
+
+uint8_t spi_queue_busy(void) {
+	return transfer_active;
+}
+
+void spi_flush(void) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	while(transfer_active) {
+		if(!interrupts_enabled) {
+			poll_transfer();
+		}
+		// else wait for the interrupt handler
+	}
+}
+
+// Interrupt handler for an SPI transfer being complete - send the next byte
+ISR(SPI_STC_vect) {
+	start_next_transfer();
+}
@@ -1,18 +1,36 @@
-/*
- * spi.h
- *
- * Author: Peter Sutton
- */ 
-
-#ifndef SPI_H_
-#define SPI_H_
-
-// Set up SPI communication as a master.
-// clockdivider should be one of 2,4,8,16,32,64,128
-void spi_setup_master(uint8_t clockdivider);
-
-// Send and receive an SPI byte. This function will take at least 8 
-// cyles of the divided clock (i.e. will busy wait).
-uint8_t spi_send_byte(uint8_t byte);
-
+/*
+ * spi.h
+ *
+ * Author: Peter Sutton
+ */ 
+
+#ifndef SPI_H_
+#define SPI_H_
+
+// Set up SPI communication as a master.
+// clockdivider should be one of 2,4,8,16,32,64,128
+// Returns 1 if successful, 0 if the SPI pins have already been claimed (see
+// ports.h).
+uint8_t spi_setup_master(uint8_t clockdivider);
+
+// Send and receive an SPI byte. This function will take at least 8 
+// cyles of the divided clock (i.e. will busy wait). Any queued bytes
+// (see below) are sent first.
+uint8_t spi_send_byte(uint8_t byte);
+
+// Background sending. Bytes are queued and sent by the SPI interrupt (the
+// bytes received are ignored) so the caller doesn't wait for each one.
+// If the queue is full spi_queue_byte() waits for room (sending bytes
+// itself if interrupts are disabled).
+#define SPI_QUEUE_SIZE 32
+
+// Queue a byte to be sent after those already queued
+void spi_queue_byte(uint8_t byte);
+
+// Returns 1 if bytes are still being sent, 0 otherwise
+uint8_t spi_queue_busy(void);
+
+// Wait until every queued byte has been sent
+void spi_flush(void);
+
 #endif /* SPI_H_ */
\ No newline at end of file
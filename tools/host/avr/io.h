@@ -0,0 +1,17 @@
+/*
+ * io.h
+ *
+ * Author: Joel Foster
+ *
+ * Stand-in for the avr-libc header so that the game's modules can be built
+ * for the development computer (see ../../replay.c). Those modules don't
+ * use any of the registers directly (their port writes go through
+ * ../../ports.h, which replay.c stands in for).
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#endif /* HOST_AVR_IO_H_ */
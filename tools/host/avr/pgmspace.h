@@ -0,0 +1,31 @@
+/*
+ * pgmspace.h
+ *
+ * Author: Joel Foster
+ *
+ * Stand-in for the avr-libc header so that the game's modules can be built
+ * for the development computer (see ../../replay.c). There is no separate
+ * program memory there, so the program memory functions just use ordinary
+ * memory.
+ */
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define printf_P printf
+#define fputs_P fputs
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
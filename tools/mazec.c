@@ -0,0 +1,446 @@
+/*
+ * mazec.c
+ *
+ * Author: Joel Foster
+ *
+ * Maze compiler. This runs on the development computer (not the AVR).
+ * It reads level files and writes a C header (maze_tables.h) containing
+ * the level pack - the compressed maze of each level and its details (see
+ * maze.h) - along with everything else that can be worked out in advance
+ * (the route home for eaten ghosts) so that it isn't done on the AVR.
+ *
+ * Usage: mazec output_file level_file...
+ * Levels are numbered in the order the files are given.
+ *
+ * A level file contains lines of settings followed by the maze:
+ *	# ...						comment (ignored)
+ *	pacman X Y DIRECTION		pac-man start (DIRECTION is left, up, right
+ *								or down)
+ *	ghost_home X_LEFT X_RIGHT Y	row of cells the ghosts start in
+ *	ghost_home_entry X_LEFT X_RIGHT Y	cells just outside the ghost home
+ *								that other ghosts can't enter
+ *	pacman_period MS			milliseconds between pac-man moves
+ *								(default 400)
+ *	ghost_period_percent PERCENT	ghosts take this percentage of their
+ *								usual time between moves (default 100)
+ *	ghosts NUMBER				number of ghosts in play, 1 to 16 (default
+ *								4) - the game plays at most MAX_GHOSTS of
+ *								them (see game.h)
+ *	field						the rest of the file is the maze
+ * The maze is one line per row. Rows shorter than the longest row are
+ * padded with spaces. Each character is one of the following:
+ *	(space) - nothing at this location
+ *	- | F 7 L J > < ^ v +	- walls (drawn with the line drawing characters
+ *							in line_drawing_characters.h)
+ *	. - pacdot initially at this location
+ *	P - power pellet initially at this location
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include "../maze.h"
+
+// These must match the values in game.h
+#define DIRN_LEFT 0
+#define DIRN_UP 1
+#define DIRN_RIGHT 2
+#define DIRN_DOWN 3
+
+// Number of ghosts in a level that doesn't say - this must match
+// NUM_GHOSTS in game.h
+#define DEFAULT_GHOSTS 4
+#define MAX_LEVEL_GHOSTS 16
+
+#define MAX_WIDTH 255
+#define MAX_HEIGHT 255
+#define MAX_LINE 1024
+
+static const char* direction_names[4] = { "left", "up", "right", "down" };
+static const char* direction_macros[4] = { "LEFT", "UP", "RIGHT", "DOWN" };
+static const int delta_x[4] = { -1, 0, 1, 0 };
+static const int delta_y[4] = { 0, -1, 0, 1 };
+
+static const char cell_characters[] = MAZE_CELL_CHARACTERS;
+
+// Everything about a level except the maze itself
+typedef struct {
+	int width;
+	int height;
+	int pacman_x, pacman_y, pacman_direction;
+	int home_x_left, home_x_right, home_y;
+	int entry_x_left, entry_x_right, entry_y;
+	int pacman_period;
+	int ghost_period_percent;
+	int num_ghosts;
+	int num_pacdots;
+	int num_dot_cells;		// cells starting with a pac-dot or power pellet
+	int maze_bytes;
+	int home_flow_bytes;
+} LevelSettings;
+
+// The level being compiled. The settings of each level are kept until the
+// end to write the table of levels.
+static LevelSettings settings;
+static char cells[MAX_HEIGHT][MAX_WIDTH + 1];
+static LevelSettings* all_settings;
+static uint8_t codes[MAX_WIDTH * MAX_HEIGHT];
+
+static FILE* out;
+static const char* out_filename;
+
+static void fail(const char* filename, int line_number, const char* format, ...) {
+	va_list args;
+	fprintf(stderr, "mazec: %s", filename);
+	if(line_number) {
+		fprintf(stderr, ":%d", line_number);
+	}
+	fprintf(stderr, ": ");
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	if(out) {
+		fclose(out);
+		remove(out_filename);
+	}
+	exit(1);
+}
+
+// Write to the output (like fprintf()), with the CRLF line endings used by
+// the rest of the project's files. The output is opened in binary mode so
+// the line endings are the same whichever computer this runs on.
+static void emit(const char* format, ...) {
+	char text[MAX_LINE];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	if(length < 0 || length >= (int)sizeof(text)) {
+		fail(out_filename, 0, "output line too long");
+	}
+	for(int i = 0; i < length; i++) {
+		if(text[i] == '\n') {
+			fputc('\r', out);
+		}
+		fputc(text[i], out);
+	}
+}
+
+static int is_open(int x, int y) {
+	if(x < 0 || y < 0 || x >= settings.width || y >= settings.height) {
+		return 0;
+	}
+	char c = cells[y][x];
+	return c == ' ' || c == '.' || c == 'P';
+}
+
+static void read_level(const char* filename) {
+	FILE* f = fopen(filename, "r");
+	if(!f) {
+		fail(filename, 0, "can't open file");
+	}
+	memset(&settings, 0, sizeof(settings));
+	memset(cells, 0, sizeof(cells));
+	settings.pacman_x = -1;
+	settings.home_y = -1;
+	settings.entry_y = -1;
+	settings.pacman_period = 400;
+	settings.ghost_period_percent = 100;
+	settings.num_ghosts = DEFAULT_GHOSTS;
+	char line[MAX_LINE];
+	int line_number = 0;
+	int in_field = 0;
+	while(fgets(line, sizeof(line), f)) {
+		line_number++;
+		line[strcspn(line, "\r\n")] = '\0';
+		if(in_field) {
+			int length = strlen(line);
+			if(settings.height == MAX_HEIGHT) {
+				fail(filename, line_number, "more than %d rows", MAX_HEIGHT);
+			}
+			if(length > MAX_WIDTH) {
+				fail(filename, line_number, "more than %d columns", MAX_WIDTH);
+			}
+			for(int x = 0; x < length; x++) {
+				if(!strchr(cell_characters, line[x])) {
+					fail(filename, line_number, "unknown character '%c'", line[x]);
+				}
+			}
+			strcpy(cells[settings.height++], line);
+			if(length > settings.width) {
+				settings.width = length;
+			}
+			continue;
+		}
+		char keyword[32];
+		char direction[32];
+		if(line[0] == '#' || sscanf(line, "%31s", keyword) != 1) {
+			continue;
+		}
+		if(strcmp(keyword, "field") == 0) {
+			in_field = 1;
+		} else if(strcmp(keyword, "pacman") == 0) {
+			if(sscanf(line, "%*s %d %d %31s", &settings.pacman_x,
+					&settings.pacman_y, direction) != 3) {
+				fail(filename, line_number, "expected: pacman X Y DIRECTION");
+			}
+			settings.pacman_direction = -1;
+			for(int d = 0; d < 4; d++) {
+				if(strcmp(direction, direction_names[d]) == 0) {
+					settings.pacman_direction = d;
+				}
+			}
+			if(settings.pacman_direction < 0) {
+				fail(filename, line_number, "unknown direction \"%s\"", direction);
+			}
+		} else if(strcmp(keyword, "ghost_home") == 0) {
+			if(sscanf(line, "%*s %d %d %d", &settings.home_x_left,
+					&settings.home_x_right, &settings.home_y) != 3) {
+				fail(filename, line_number, "expected: ghost_home X_LEFT X_RIGHT Y");
+			}
+		} else if(strcmp(keyword, "ghost_home_entry") == 0) {
+			if(sscanf(line, "%*s %d %d %d", &settings.entry_x_left,
+					&settings.entry_x_right, &settings.entry_y) != 3) {
+				fail(filename, line_number,
+						"expected: ghost_home_entry X_LEFT X_RIGHT Y");
+			}
+		} else if(strcmp(keyword, "pacman_period") == 0) {
+			if(sscanf(line, "%*s %d", &settings.pacman_period) != 1
+					|| settings.pacman_period < 1
+					|| settings.pacman_period > 65535) {
+				fail(filename, line_number, "expected: pacman_period MS");
+			}
+		} else if(strcmp(keyword, "ghost_period_percent") == 0) {
+			if(sscanf(line, "%*s %d", &settings.ghost_period_percent) != 1
+					|| settings.ghost_period_percent < 1
+					|| settings.ghost_period_percent > 255) {
+				fail(filename, line_number,
+						"expected: ghost_period_percent PERCENT (1 to 255)");
+			}
+		} else if(strcmp(keyword, "ghosts") == 0) {
+			if(sscanf(line, "%*s %d", &settings.num_ghosts) != 1
+					|| settings.num_ghosts < 1
+					|| settings.num_ghosts > MAX_LEVEL_GHOSTS) {
+				fail(filename, line_number, "expected: ghosts NUMBER (1 to %d)",
+						MAX_LEVEL_GHOSTS);
+			}
+		} else {
+			fail(filename, line_number, "unknown setting \"%s\"", keyword);
+		}
+	}
+	fclose(f);
+
+	// Drop blank rows at the end, pad short rows with spaces
+	while(settings.height > 0 && cells[settings.height - 1][0] == '\0') {
+		settings.height--;
+	}
+	if(settings.height == 0) {
+		fail(filename, 0, "no field");
+	}
+	for(int y = 0; y < settings.height; y++) {
+		for(int x = strlen(cells[y]); x < settings.width; x++) {
+			cells[y][x] = ' ';
+		}
+		cells[y][settings.width] = '\0';
+	}
+
+	if(settings.pacman_x < 0) {
+		fail(filename, 0, "no pacman setting");
+	}
+	if(!is_open(settings.pacman_x, settings.pacman_y)) {
+		fail(filename, 0, "pac-man doesn't start on an open cell");
+	}
+	if(settings.home_y < 0 || settings.entry_y < 0) {
+		fail(filename, 0, "no ghost_home or ghost_home_entry setting");
+	}
+	if(settings.home_x_left > settings.home_x_right
+			|| settings.entry_x_left > settings.entry_x_right) {
+		fail(filename, 0, "ghost home X_LEFT is right of X_RIGHT");
+	}
+	for(int x = settings.home_x_left; x <= settings.home_x_right; x++) {
+		if(!is_open(x, settings.home_y)) {
+			fail(filename, 0, "ghost home cell (%d,%d) isn't open",
+					x, settings.home_y);
+		}
+	}
+	for(int x = settings.entry_x_left; x <= settings.entry_x_right; x++) {
+		if(!is_open(x, settings.entry_y)) {
+			fail(filename, 0, "ghost home entry cell (%d,%d) isn't open",
+					x, settings.entry_y);
+		}
+	}
+}
+
+// Write the codes array (one code per cell) as a run length encoded stream
+// (see maze.h). If row_offsets isn't NULL the offset of the first byte of
+// each row is stored in it. Returns the length of the stream in bytes.
+static int write_stream(int level_number, const char* name, int* row_offsets) {
+	int length = 0;
+	emit("static const uint8_t level_%d_%s[] PROGMEM = {\n",
+			level_number, name);
+	for(int y = 0; y < settings.height; y++) {
+		if(row_offsets) {
+			row_offsets[y] = length;
+		}
+		emit("\t");
+		const uint8_t* row = &codes[y * settings.width];
+		int x = 0;
+		while(x < settings.width) {
+			int run = 1;
+			while(x + run < settings.width && run < MAZE_MAX_RUN
+					&& row[x + run] == row[x]) {
+				run++;
+			}
+			emit("%s0x%02X,", x ? " " : "", (row[x] << 4) | (run - 1));
+			length++;
+			x += run;
+		}
+		emit("\n");
+	}
+	emit("};\n\n");
+	return length;
+}
+
+static void write_maze(int level_number) {
+	settings.num_pacdots = 0;
+	settings.num_dot_cells = 0;
+	for(int y = 0; y < settings.height; y++) {
+		for(int x = 0; x < settings.width; x++) {
+			char c = cells[y][x];
+			codes[y * settings.width + x] = strchr(cell_characters, c)
+					- cell_characters;
+			settings.num_pacdots += (c == '.');
+			settings.num_dot_cells += (c == '.' || c == 'P');
+		}
+	}
+	settings.maze_bytes = write_stream(level_number, "maze", NULL);
+}
+
+// Direction to step in from each cell to get closer to the ghost home - a
+// breadth first search out from the ghost home. Where there is a choice,
+// directions are preferred in the order up, left, down, right.
+static void write_home_flow(int level_number) {
+	static const int preference[4] = { DIRN_UP, DIRN_LEFT, DIRN_DOWN, DIRN_RIGHT };
+	static int queue[MAX_WIDTH * MAX_HEIGHT];
+	int head = 0;
+	int tail = 0;
+	memset(codes, FLOW_NO_ROUTE, sizeof(codes));
+	for(int x = settings.home_x_left; x <= settings.home_x_right; x++) {
+		codes[settings.home_y * settings.width + x] = FLOW_AT_HOME;
+		queue[tail++] = settings.home_y * settings.width + x;
+	}
+	while(head < tail) {
+		int x = queue[head] % settings.width;
+		int y = queue[head] / settings.width;
+		head++;
+		for(int i = 0; i < 4; i++) {
+			// The cell that stepping in direction d takes to (x,y)
+			int d = preference[i];
+			int nx = x - delta_x[d];
+			int ny = y - delta_y[d];
+			if(is_open(nx, ny) && codes[ny * settings.width + nx] == FLOW_NO_ROUTE) {
+				codes[ny * settings.width + nx] = d;
+				queue[tail++] = ny * settings.width + nx;
+			}
+		}
+	}
+	int row_offsets[MAX_HEIGHT];
+	settings.home_flow_bytes = write_stream(level_number, "home_flow", row_offsets);
+	emit("static const uint16_t level_%d_home_flow_rows[%d] PROGMEM = {\n",
+			level_number, settings.height);
+	for(int y = 0; y < settings.height; y++) {
+		emit("%s%d,%s", (y % 16) ? " " : "\t", row_offsets[y],
+				(y % 16 == 15 || y == settings.height - 1) ? "\n" : "");
+	}
+	emit("};\n\n");
+}
+
+static void write_level(int level_number, const char* filename) {
+	// Leave out the directory
+	const char* name = filename;
+	for(const char* c = filename; *c; c++) {
+		if(*c == '/' || *c == '\\') {
+			name = c + 1;
+		}
+	}
+	emit("// Level %d - from levels/%s\n", level_number, name);
+	write_maze(level_number);
+	write_home_flow(level_number);
+}
+
+static void write_level_data(int level_number, const LevelSettings* level) {
+	emit("\t{\t// Level %d (%d + %d bytes)\n", level_number,
+			level->maze_bytes, level->home_flow_bytes);
+	emit("\t\t.width = %d, .height = %d,\n", level->width, level->height);
+	emit("\t\t.pacman_x = %d, .pacman_y = %d, .pacman_direction = DIRN_%s,\n",
+			level->pacman_x, level->pacman_y,
+			direction_macros[level->pacman_direction]);
+	emit("\t\t.ghost_home_x_left = %d, .ghost_home_x_right = %d, "
+			".ghost_home_y = %d,\n",
+			level->home_x_left, level->home_x_right, level->home_y);
+	emit("\t\t.ghost_home_entry_x_left = %d, .ghost_home_entry_x_right = %d, "
+			".ghost_home_entry_y = %d,\n",
+			level->entry_x_left, level->entry_x_right, level->entry_y);
+	emit("\t\t.pacman_move_period = %d, .ghost_period_percent = %d,\n",
+			level->pacman_period, level->ghost_period_percent);
+	emit("\t\t.num_ghosts = %d,\n", level->num_ghosts);
+	emit("\t\t.num_pacdots = %d,\n", level->num_pacdots);
+	emit("\t\t.maze = level_%d_maze,\n", level_number);
+	emit("\t\t.home_flow = level_%d_home_flow,\n", level_number);
+	emit("\t\t.home_flow_rows = level_%d_home_flow_rows,\n", level_number);
+	emit("\t},\n");
+}
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		fprintf(stderr, "usage: mazec output_file level_file...\n");
+		return 1;
+	}
+	out_filename = argv[1];
+	out = fopen(out_filename, "wb");
+	if(!out) {
+		fail(out_filename, 0, "can't create file");
+	}
+	int num_levels = argc - 2;
+	int max_width = 0;
+	int max_height = 0;
+	int max_dot_cells = 0;
+
+	emit("/*\n * maze_tables.h\n *\n"
+			" * Generated by tools/mazec.c from the files in levels/ - do not edit.\n"
+			" * See maze.h for a description of the level pack.\n */\n\n"
+			"#ifndef MAZE_TABLES_H_\n#define MAZE_TABLES_H_\n\n"
+			"#include <avr/pgmspace.h>\n#include \"maze.h\"\n\n");
+	all_settings = calloc(num_levels, sizeof(LevelSettings));
+	for(int i = 0; i < num_levels; i++) {
+		read_level(argv[i + 2]);
+		write_level(i, argv[i + 2]);
+		all_settings[i] = settings;
+		if(settings.width > max_width) {
+			max_width = settings.width;
+		}
+		if(settings.height > max_height) {
+			max_height = settings.height;
+		}
+		if(settings.num_dot_cells > max_dot_cells) {
+			max_dot_cells = settings.num_dot_cells;
+		}
+	}
+	emit("#define NUM_LEVELS %d\n", num_levels);
+	emit("#define LEVELS_MAX_WIDTH %d\n", max_width);
+	emit("#define LEVELS_MAX_HEIGHT %d\n", max_height);
+	emit("#define LEVELS_MAX_DOT_CELLS %d\n\n", max_dot_cells);
+	emit("static const LevelData levels[NUM_LEVELS] PROGMEM = {\n");
+	for(int i = 0; i < num_levels; i++) {
+		write_level_data(i, &all_settings[i]);
+	}
+	emit("};\n\n#endif /* MAZE_TABLES_H_ */\n");
+	if(fclose(out) != 0) {
+		out = NULL;
+		fail(out_filename, 0, "write failed");
+	}
+	return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * replay.c
+ *
+ * Author: Joel Foster
+ *
+ * Game replayer. This runs on the development computer (not the AVR).
+ * It reads a capture of the board's serial output (e.g. a terminal
+ * program's log of everything received), picks out the journal records
+ * (see ../journal.h) and either
+ *	- replays each game recorded there with the game's own code (built for
+ *	  this computer) and checks that it ends exactly as it did on the board,
+ *	  reporting how long the replay took (so a capture can be used as a
+ *	  repeatable workload for timing the game code), or
+ *	- feeds the records of one game back to the board, which replays it
+ *	  (after 'r' is pressed).
+ *
+ * Usage: replay [-v] [-g GAME] capture_file
+ *		replay -f [-v] [-g GAME] capture_file <board_output >board_input
+ *	-v		show the game (replay) or the board's output (feed) on the
+ *			terminal (standard error for feed)
+ *	-g GAME	only use the given game (1 is the first one in the capture) -
+ *			feeding uses the first game if this isn't given
+ *	-f		feed the records to the board - the board's serial output must
+ *			be connected to standard input and its serial input to standard
+ *			output (e.g. with socat or by redirecting from and to the port)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "game.h"
+#include "score.h"
+#include "prng.h"
+#include "journal.h"
+
+#define ESCAPE_CHAR 27
+#define MAX_RECORD 32
+
+// Types of record - as in journal.c
+#define RECORD_START 'S'
+#define RECORD_END 'E'
+
+// There are no lives LEDs here - the game's writes to them (see
+// ../ports.h) do nothing
+void ports_write(uint8_t port, uint8_t pins, uint8_t value) {
+	(void)port;
+	(void)pins;
+	(void)value;
+}
+
+// The LED matrix isn't used here - the game's calls to show changes on it
+// (see ../maze_view.h) do nothing
+void maze_view_cell_changed(uint8_t x, uint8_t y) {
+	(void)x;
+	(void)y;
+}
+
+void maze_view_field_changed(void) {
+}
+
+typedef struct {
+	uint8_t type;		// RECORD_START, RECORD_END or an event (JOURNAL_...)
+	uint32_t tick;
+	uint16_t value;		// seed or checksum
+	char text[MAX_RECORD];	// the record as it appeared in the capture
+} Record;
+
+static Record* records;
+static int num_records;
+
+// Position of the next record to replay, and the joystick direction (or
+// -1) from the records so far
+static int next_record;
+static int8_t held_direction;
+
+static void fail(const char* message, const char* name) {
+	fprintf(stderr, "replay: %s%s\n", message, name);
+	exit(1);
+}
+
+static void add_record(const char* text) {
+	Record record;
+	char* rest;
+	memset(&record, 0, sizeof(record));
+	strncpy(record.text, text, MAX_RECORD - 1);
+	if(text[0] == RECORD_START) {
+		record.type = RECORD_START;
+		record.value = strtoul(text + 1, &rest, 10);
+	} else if(text[0] == RECORD_END) {
+		record.type = RECORD_END;
+		record.tick = strtoul(text + 1, &rest, 10);
+		record.value = strtoul(rest, &rest, 10);
+	} else if(text[0] >= '0' && text[0] <= '9') {
+		record.tick = strtoul(text, &rest, 10);
+		record.type = strtoul(rest, &rest, 10);
+	} else {
+		// The board asking for a record (during a replay) - not part of
+		// a game
+		return;
+	}
+	records = realloc(records, (num_records + 1) * sizeof(Record));
+	if(!records) {
+		fail("out of memory", "");
+	}
+	records[num_records++] = record;
+}
+
+// Pick the records out of the capture - each one is ESC _ J record ESC \.
+// Anything else in the capture (the game's own output) is ignored.
+static void read_capture(const char* filename) {
+	FILE* capture = fopen(filename, "rb");
+	if(!capture) {
+		fail("can't open ", filename);
+	}
+	char text[MAX_RECORD];
+	int length = -1;	// -1 when not in a record
+	int previous = 0;
+	int c;
+	while((c = fgetc(capture)) != EOF) {
+		if(previous == ESCAPE_CHAR && c == '_') {
+			length = 0;
+		} else if(length >= 0 && c == ESCAPE_CHAR) {
+			text[length] = 0;
+			if(strncmp(text, "J ", 2) == 0) {
+				add_record(text + 2);
+			}
+			length = -1;
+		} else if(length >= 0 && length < MAX_RECORD - 1) {
+			text[length++] = c;
+		}
+		previous = c;
+	}
+	fclose(capture);
+}
+
+// Returns the position of the start record of the given game (1 for the
+// first), or -1 if there isn't one
+static int find_game(int game) {
+	for(int i = 0; i < num_records; i++) {
+		if(records[i].type == RECORD_START && --game == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Get the input for the given tick from the records - the same as
+// journal_replay_input() does on the board. Returns 0 if the game's
+// records have ended before this tick.
+static int replay_input(uint32_t tick, int8_t* held, int8_t* pushed) {
+	*held = -1;
+	*pushed = -1;
+	while(next_record < num_records) {
+		Record* record = &records[next_record];
+		if(record->type == RECORD_START) {
+			return 0;
+		}
+		if(record->tick > tick) {
+			*held = held_direction;
+			return 1;
+		}
+		if(record->type == RECORD_END || record->type == JOURNAL_LOADED) {
+			return 0;
+		}
+		if(record->type < JOURNAL_HELD_NONE) {
+			held_direction = record->type - JOURNAL_HELD_LEFT;
+		} else if(record->type == JOURNAL_HELD_NONE) {
+			held_direction = -1;
+		} else if(record->type >= JOURNAL_PUSHED_LEFT
+				&& record->type < JOURNAL_PUSHED_LEFT + 4) {
+			*pushed = record->type - JOURNAL_PUSHED_LEFT;
+		}
+		next_record++;
+	}
+	return 0;
+}
+
+// Replay the game whose start record is at position start. Returns 1 if it
+// ended the same way as on the board.
+static int replay_game(int game, int start) {
+	int8_t held, pushed;
+	uint16_t seed = records[start].value;
+	next_record = start + 1;
+	held_direction = -1;
+	clock_t start_time = clock();
+	initialise_game();
+	init_score();
+	prng_seed(seed);
+	while(!is_game_over()) {
+		if(!replay_input(get_game_ticks(), &held, &pushed)) {
+			break;
+		}
+		game_step(held, pushed);
+		if(is_level_complete()) {
+			start_next_level();
+		}
+	}
+	double seconds = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+	uint32_t ticks = get_game_ticks();
+	uint16_t checksum = get_game_checksum();
+	fprintf(stderr, "game %d: seed %u, %lu ticks, score %lu, %.3f s (%.2f us per tick): ",
+			game, seed, (unsigned long)ticks, (unsigned long)get_score(), seconds,
+			ticks ? seconds * 1e6 / ticks : 0.0);
+	// The game's end (or load) record - there may be input left over if the
+	// game ended early here
+	Record* end = NULL;
+	for(int i = next_record; i < num_records && records[i].type != RECORD_START; i++) {
+		if(records[i].type == RECORD_END || records[i].type == JOURNAL_LOADED) {
+			end = &records[i];
+			break;
+		}
+	}
+	if(end && end->type == JOURNAL_LOADED) {
+		fprintf(stderr, "loaded from EEPROM or stepped back at tick %lu - can't replay further\n",
+				(unsigned long)end->tick);
+		return 0;
+	} else if(!end) {
+		fprintf(stderr, "no end record in the capture\n");
+		return 0;
+	} else if(end->tick != ticks || end->value != checksum) {
+		fprintf(stderr, "DIFFERS (board: %lu ticks, checksum %u; here: checksum %u)\n",
+				(unsigned long)end->tick, end->value, checksum);
+		return 0;
+	}
+	fprintf(stderr, "matches\n");
+	return 1;
+}
+
+// Send the records of the game starting at position start to the board,
+// one each time it asks for one (ESC _ J ? ESC \). Escape is sent if it
+// asks for more after the end of the game.
+static void feed_game(int start, int verbose) {
+	static const char request[] = "\x1b_J ?\x1b\\";
+	int matched = 0;
+	int next = start;
+	int c;
+	while((c = getchar()) != EOF) {
+		if(verbose) {
+			fputc(c, stderr);
+		}
+		if(c == request[matched]) {
+			matched++;
+		} else {
+			matched = (c == request[0]);
+		}
+		if(request[matched] != 0) {
+			continue;
+		}
+		matched = 0;
+		if(next < num_records && (next == start || records[next].type != RECORD_START)) {
+			printf("%s\n", records[next].text);
+			next++;
+		} else {
+			putchar(ESCAPE_CHAR);
+		}
+		fflush(stdout);
+	}
+}
+
+int main(int argc, char** argv) {
+	int verbose = 0;
+	int feed = 0;
+	int game = 0;
+	int arg = 1;
+	for(; arg < argc && argv[arg][0] == '-'; arg++) {
+		if(strcmp(argv[arg], "-v") == 0) {
+			verbose = 1;
+		} else if(strcmp(argv[arg], "-f") == 0) {
+			feed = 1;
+		} else if(strcmp(argv[arg], "-g") == 0 && arg + 1 < argc) {
+			game = atoi(argv[++arg]);
+		} else {
+			fail("unknown option ", argv[arg]);
+		}
+	}
+	if(arg != argc - 1) {
+		fprintf(stderr, "Usage: replay [-f] [-v] [-g GAME] capture_file\n");
+		return 1;
+	}
+	read_capture(argv[arg]);
+	if(feed) {
+		int start = find_game(game ? game : 1);
+		if(start < 0) {
+			fail("game not found in ", argv[arg]);
+		}
+		feed_game(start, verbose);
+		return 0;
+	}
+	if(!verbose) {
+		// The game's output isn't wanted
+#ifdef _WIN32
+		freopen("NUL", "w", stdout);
+#else
+		freopen("/dev/null", "w", stdout);
+#endif
+	}
+	int games = 0;
+	int failures = 0;
+	for(int i = 1; find_game(i) >= 0; i++) {
+		if(game == 0 || game == i) {
+			games++;
+			failures += !replay_game(i, find_game(i));
+		}
+	}
+	if(games == 0) {
+		fail("no games found in ", argv[arg]);
+	}
+	return failures ? 1 : 0;
+}